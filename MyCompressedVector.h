@@ -0,0 +1,510 @@
+#ifndef MyCompressedVector_H
+#define MyCompressedVector_H
+
+#include <type_traits>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+#include "MyVector.h"
+#include "VectorException.h"
+
+// Сжатый вектор целых чисел только для чтения. Элементы разбиваются на блоки по BLOCK_SIZE,
+// каждый блок кодируется либо через frame-of-reference (значение минус минимум блока), либо,
+// если блок отсортирован и так выходит короче, через дельты соседних элементов. Полученные
+// значения упаковываются в минимально необходимое число бит. Доступ по индексу в DELTA-блоке
+// стоит O(позиции в блоке), а не O(1).
+template <typename T> class MyCompressedVector {
+    static_assert(std::is_integral<T>::value, "MyCompressedVector supports only integral types");
+
+public:
+    // количество элементов в одном блоке
+    static const int BLOCK_SIZE = 128;
+
+private:
+    // способ кодирования блока
+    enum Encoding : unsigned char {
+        FRAME_OF_REFERENCE = 0,
+        DELTA = 1
+    };
+
+    // заголовок блока: опорное значение, смещение в упакованном массиве и ширина в битах
+    struct BlockHeader {
+        unsigned long long base;
+        long long offset;
+        unsigned char width;
+        unsigned char encoding;
+    };
+
+    MyVector<BlockHeader> blocks;
+    MyVector<unsigned long long> packed;
+    int length;
+
+    // проверяет индекс на соответствие границам вектора
+    void checkBounds(int index) const;
+
+    // количество бит, необходимое для хранения значения
+    static unsigned char bitWidth(unsigned long long value);
+
+    // преобразование элемента в беззнаковое 64-битное представление и обратно
+    static unsigned long long toBits(T value);
+    static T fromBits(unsigned long long bits);
+
+    // извлечь упакованное значение с номером index из блока
+    unsigned long long extract(const BlockHeader &header, int index) const;
+
+    // распаковать count полей шириной width (1..63) из words в values
+    static void unpack(const unsigned long long *words, int width, int count, unsigned long long *values);
+
+    // values[i] = base + values[0] + ... + values[i] (по модулю 2^64)
+    static void prefixSum(unsigned long long *values, int count, unsigned long long base);
+
+public:
+    class Iterator
+    {
+    private:
+        const MyCompressedVector<T> *vector;
+        T buffer[BLOCK_SIZE];
+        int currentIndex;
+        int bufferedBlock;
+
+        // распаковать блок, в который попадает текущий индекс
+        void fillBuffer();
+    public:
+        // конструктор, принимающий сжатый вектор и индекс, с которого начинается обход
+        Iterator(const MyCompressedVector<T> &vector, int index = 0);
+
+        // перейти к следующему объекту в контейнере
+        Iterator &next();
+
+        // получить значение текущего объекта в контейнере
+        T value();
+
+        // указывает ли итератор на конечный фиктивный элемент контейнера, следующий за последним
+        // реальным
+        bool is_end() const;
+
+        // префиксный инкремент, эквивалентен next()
+        Iterator &operator++();
+
+        // оператор разыменования, эквивалентен value()
+        T operator*();
+
+        // оператор сравнения на равенство (по позиции)
+        bool operator == (const Iterator &b) const;
+
+        // оператор сравнения на неравенство (по позиции)
+        bool operator != (const Iterator &b) const;
+    };
+
+    // конструктор, сжимающий существующий вектор
+    explicit MyCompressedVector(const MyVector<T> &vector);
+
+    // получить текущий размер
+    int get_length() const;
+
+    // получить объём памяти, занимаемый сжатыми данными, в байтах
+    long long get_compressed_size() const;
+
+    // получить элемент по индексу; в блоке frame-of-reference извлекается одно поле, а в
+    // DELTA-блоке суммируются все дельты от начала блока (до BLOCK_SIZE - 1 полей), поэтому
+    // для последовательного чтения лучше использовать итератор или decode_block
+    T get_elem(int index) const;
+
+    // доступ к элементу, аналогично массиву (только чтение)
+    T operator [](int index) const;
+
+    // распаковать блок с номером blockIndex в массив out, возвращает число элементов блока
+    int decode_block(int blockIndex, T *out) const;
+
+    // распаковать вектор целиком обратно в MyVector
+    MyVector<T> decompress() const;
+
+    // метод получения итератора на начало вектора (первый элемент)
+    Iterator iterator_begin() const;
+
+    // метод получения итератора на конец вектора (фиктивный элемент, следующий за последним)
+    Iterator iterator_end() const;
+};
+
+// определение нужно, когда BLOCK_SIZE передаётся по ссылке (std::min) без оптимизации
+template<typename T> const int MyCompressedVector<T>::BLOCK_SIZE;
+
+// проверяет индекс на соответствие границам вектора
+template<typename T> void MyCompressedVector<T>::checkBounds(int index) const
+{
+    if (index < 0)
+        throw VectorException("Index must be greater than zero");
+
+    if (length <= index)
+        throw VectorException("Index out of range");
+}
+
+// количество бит, необходимое для хранения значения
+template<typename T> unsigned char MyCompressedVector<T>::bitWidth(unsigned long long value)
+{
+    unsigned char width = 0;
+    while (value != 0) {
+        value >>= 1;
+        width++;
+    }
+    return width;
+}
+
+// преобразование элемента в беззнаковое 64-битное представление
+template<typename T> unsigned long long MyCompressedVector<T>::toBits(T value)
+{
+    // для знаковых типов расширение знака сохраняет порядок разностей по модулю 2^64
+    if (std::is_signed<T>::value)
+        return (unsigned long long)(long long)value;
+
+    return (unsigned long long)value;
+}
+
+// преобразование из беззнакового 64-битного представления обратно в элемент
+template<typename T> T MyCompressedVector<T>::fromBits(unsigned long long bits)
+{
+    return (T)bits;
+}
+
+// извлечь упакованное значение с номером index из блока
+template<typename T> unsigned long long MyCompressedVector<T>::extract(const BlockHeader &header, int index) const
+{
+    if (header.width == 0)
+        return 0;
+
+    const unsigned long long *words = packed.data() + header.offset;
+    long long bit = (long long)index * header.width;
+    long long word = bit >> 6;
+    int shift = (int)(bit & 63);
+
+    unsigned long long result = words[word] >> shift;
+    if (shift + header.width > 64)
+        result |= words[word + 1] << (64 - shift);
+
+    if (header.width < 64)
+        result &= (1ULL << header.width) - 1;
+
+    return result;
+}
+
+// распаковать count полей шириной width (1..63) из words в values
+template<typename T> void MyCompressedVector<T>::unpack(const unsigned long long *words, int width, int count,
+                                                        unsigned long long *values)
+{
+    const unsigned long long mask = (1ULL << width) - 1;
+    int i = 0;
+
+#if defined(__AVX2__)
+    // по четыре поля за шаг: слова полей собираются gather, второе слово читается только
+    // для полей, пересекающих границу слова (маска gather, за концом массива чтения нет);
+    // сдвиги с переменным счётчиком дают 0 при сдвиге на 64, поэтому shift == 0 не особый случай
+    const __m256i maskVector = _mm256_set1_epi64x((long long)mask);
+    const __m256i limit = _mm256_set1_epi64x(64);
+    const __m256i low6 = _mm256_set1_epi64x(63);
+    const __m256i widthVector = _mm256_set1_epi64x(width);
+    const __m256i one = _mm256_set1_epi64x(1);
+    const __m256i step = _mm256_set1_epi64x(4LL * width);
+    __m256i bit = _mm256_set_epi64x(3LL * width, 2LL * width, width, 0);
+    const long long *base = reinterpret_cast<const long long *>(words);
+    for(; i + 4 <= count; i += 4) {
+        __m256i word = _mm256_srli_epi64(bit, 6);
+        __m256i shift = _mm256_and_si256(bit, low6);
+        __m256i low = _mm256_i64gather_epi64(base, word, 8);
+        __m256i crosses = _mm256_cmpgt_epi64(_mm256_add_epi64(shift, widthVector), limit);
+        __m256i high = _mm256_mask_i64gather_epi64(_mm256_setzero_si256(), base, _mm256_add_epi64(word, one),
+                                                   crosses, 8);
+        __m256i value = _mm256_or_si256(_mm256_srlv_epi64(low, shift),
+                                        _mm256_sllv_epi64(high, _mm256_sub_epi64(limit, shift)));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(values + i), _mm256_and_si256(value, maskVector));
+        bit = _mm256_add_epi64(bit, step);
+    }
+#endif
+
+    for(; i < count; i++) {
+        long long bit = (long long)i * width;
+        int word = (int)(bit >> 6);
+        int shift = (int)(bit & 63);
+        // второе слово читается только для поля, выходящего за границу первого; сдвиг на 64
+        // заменён двумя сдвигами, чтобы избежать UB при shift == 0
+        unsigned long long high = (shift + width > 64) ? words[word + 1] : 0;
+        values[i] = ((words[word] >> shift) | ((high << 1) << (63 - shift))) & mask;
+    }
+}
+
+// values[i] = base + values[0] + ... + values[i] (по модулю 2^64)
+template<typename T> void MyCompressedVector<T>::prefixSum(unsigned long long *values, int count,
+                                                           unsigned long long base)
+{
+    int i = 0;
+
+#if defined(__AVX2__)
+    // префиксная сумма четырёх элементов регистра двумя сдвигами на 1 и 2 элемента,
+    // затем прибавляется перенос от предыдущих четвёрок
+    __m256i running = _mm256_set1_epi64x((long long)base);
+    for(; i + 4 <= count; i += 4) {
+        __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(values + i));
+        x = _mm256_add_epi64(x, _mm256_blend_epi32(_mm256_permute4x64_epi64(x, _MM_SHUFFLE(2, 1, 0, 0)),
+                                                   _mm256_setzero_si256(), 0x03));
+        x = _mm256_add_epi64(x, _mm256_blend_epi32(_mm256_permute4x64_epi64(x, _MM_SHUFFLE(1, 0, 0, 0)),
+                                                   _mm256_setzero_si256(), 0x0f));
+        x = _mm256_add_epi64(x, running);
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(values + i), x);
+        running = _mm256_permute4x64_epi64(x, _MM_SHUFFLE(3, 3, 3, 3));
+    }
+    if (i > 0)
+        base = values[i - 1];
+#endif
+
+    for(; i < count; i++) {
+        base += values[i];
+        values[i] = base;
+    }
+}
+
+// конструктор, сжимающий существующий вектор
+template<typename T> MyCompressedVector<T>::MyCompressedVector(const MyVector<T> &vector) :
+    blocks((vector.get_length() + BLOCK_SIZE - 1) / BLOCK_SIZE), packed(0), length(vector.get_length())
+{
+    const T *source = vector.data();
+    BlockHeader *headers = blocks.data();
+    long long totalWords = 0;
+
+    // первый проход: выбор кодирования и ширины каждого блока
+    for(int b = 0; b < blocks.get_length(); b++) {
+        int begin = b * BLOCK_SIZE;
+        int count = std::min(BLOCK_SIZE, length - begin);
+
+        T minimum = source[begin];
+        bool sorted = true;
+        unsigned long long maxDelta = 0;
+        for(int i = 1; i < count; i++) {
+            if (source[begin + i] < minimum)
+                minimum = source[begin + i];
+            if (source[begin + i] < source[begin + i - 1])
+                sorted = false;
+            else
+                maxDelta = std::max(maxDelta, toBits(source[begin + i]) - toBits(source[begin + i - 1]));
+        }
+
+        unsigned long long maxOffset = 0;
+        for(int i = 0; i < count; i++)
+            maxOffset = std::max(maxOffset, toBits(source[begin + i]) - toBits(minimum));
+
+        BlockHeader &header = headers[b];
+        header.offset = totalWords;
+        if (sorted && bitWidth(maxDelta) < bitWidth(maxOffset)) {
+            header.encoding = DELTA;
+            header.base = toBits(source[begin]);
+            header.width = bitWidth(maxDelta);
+        } else {
+            header.encoding = FRAME_OF_REFERENCE;
+            header.base = toBits(minimum);
+            header.width = bitWidth(maxOffset);
+        }
+
+        totalWords += ((long long)count * header.width + 63) / 64;
+    }
+
+    if (totalWords > 0x7fffffff)
+        throw VectorException("Compressed data is too large");
+
+    // второй проход: упаковка значений
+    packed = MyVector<unsigned long long>((int)totalWords);
+    unsigned long long *words = packed.data();
+
+    for(int b = 0; b < blocks.get_length(); b++) {
+        const BlockHeader &header = headers[b];
+        if (header.width == 0)
+            continue;
+
+        int begin = b * BLOCK_SIZE;
+        int count = std::min(BLOCK_SIZE, length - begin);
+        unsigned long long *blockWords = words + header.offset;
+
+        for(int i = 0; i < count; i++) {
+            unsigned long long value;
+            if (header.encoding == DELTA)
+                value = (i == 0) ? 0 : toBits(source[begin + i]) - toBits(source[begin + i - 1]);
+            else
+                value = toBits(source[begin + i]) - header.base;
+
+            long long bit = (long long)i * header.width;
+            long long word = bit >> 6;
+            int shift = (int)(bit & 63);
+
+            blockWords[word] |= value << shift;
+            if (shift + header.width > 64)
+                blockWords[word + 1] |= value >> (64 - shift);
+        }
+    }
+}
+
+// получить текущий размер
+template<typename T> int MyCompressedVector<T>::get_length() const
+{
+    return length;
+}
+
+// получить объём памяти, занимаемый сжатыми данными, в байтах
+template<typename T> long long MyCompressedVector<T>::get_compressed_size() const
+{
+    return (long long)blocks.get_length() * sizeof(BlockHeader) +
+           (long long)packed.get_length() * sizeof(unsigned long long);
+}
+
+// получить элемент по индексу (распаковывается только нужная часть блока)
+template<typename T> T MyCompressedVector<T>::get_elem(int index) const
+{
+    checkBounds(index);
+
+    const BlockHeader &header = blocks.data()[index / BLOCK_SIZE];
+    int position = index % BLOCK_SIZE;
+
+    if (header.encoding == FRAME_OF_REFERENCE)
+        return fromBits(header.base + extract(header, position));
+
+    unsigned long long value = header.base;
+    for(int i = 1; i <= position; i++)
+        value += extract(header, i);
+
+    return fromBits(value);
+}
+
+// доступ к элементу, аналогично массиву (только чтение)
+template<typename T> T MyCompressedVector<T>::operator [](int index) const
+{
+    return get_elem(index);
+}
+
+// распаковать блок с номером blockIndex в массив out, возвращает число элементов блока
+template<typename T> int MyCompressedVector<T>::decode_block(int blockIndex, T *out) const
+{
+    if (blockIndex < 0 || blocks.get_length() <= blockIndex)
+        throw VectorException("Block index out of range");
+
+    const BlockHeader &header = blocks.data()[blockIndex];
+    int count = std::min(BLOCK_SIZE, length - blockIndex * BLOCK_SIZE);
+
+    // распаковка битовых полей во временный буфер фиксированного размера. Распаковка и
+    // префиксная сумма DELTA-блоков имеют явные AVX2-ядра (нужна сборка с -mavx2 или
+    // -march=native), без AVX2 работают скалярные циклы; последний цикл - простое
+    // преобразование типа, его векторизует сам компилятор при -O3
+    unsigned long long values[BLOCK_SIZE];
+    if (header.width == 0) {
+        for(int i = 0; i < count; i++)
+            values[i] = 0;
+    } else if (header.width == 64) {
+        const unsigned long long *words = packed.data() + header.offset;
+        for(int i = 0; i < count; i++)
+            values[i] = words[i];
+    } else {
+        unpack(packed.data() + header.offset, header.width, count, values);
+    }
+
+    if (header.encoding == DELTA) {
+        prefixSum(values, count, header.base);
+        for(int i = 0; i < count; i++)
+            out[i] = fromBits(values[i]);
+    } else {
+        const unsigned long long base = header.base;
+        for(int i = 0; i < count; i++)
+            out[i] = fromBits(base + values[i]);
+    }
+
+    return count;
+}
+
+// распаковать вектор целиком обратно в MyVector
+template<typename T> MyVector<T> MyCompressedVector<T>::decompress() const
+{
+    MyVector<T> result(length);
+    T *target = result.data();
+
+    for(int b = 0; b < blocks.get_length(); b++)
+        decode_block(b, target + b * BLOCK_SIZE);
+
+    return result;
+}
+
+// метод получения итератора на начало вектора (первый элемент)
+template<typename T> typename MyCompressedVector<T>::Iterator MyCompressedVector<T>::iterator_begin() const
+{
+    return Iterator(*this, 0);
+}
+
+// метод получения итератора на конец вектора (фиктивный элемент, следующий за последним)
+template<typename T> typename MyCompressedVector<T>::Iterator MyCompressedVector<T>::iterator_end() const
+{
+    return Iterator(*this, length);
+}
+
+
+// конструктор, принимающий сжатый вектор и индекс, с которого начинается обход
+template<typename T> MyCompressedVector<T>::Iterator::Iterator(const MyCompressedVector<T> &vector, int index) :
+    vector(&vector), currentIndex(index), bufferedBlock(-1)
+{
+}
+
+// распаковать блок, в который попадает текущий индекс
+template<typename T> void MyCompressedVector<T>::Iterator::fillBuffer()
+{
+    int block = currentIndex / BLOCK_SIZE;
+    if (block != bufferedBlock) {
+        vector->decode_block(block, buffer);
+        bufferedBlock = block;
+    }
+}
+
+// перейти к следующему объекту в контейнере
+template<typename T> typename MyCompressedVector<T>::Iterator &MyCompressedVector<T>::Iterator::next()
+{
+    if (!is_end())
+        currentIndex += 1;
+
+    return *this;
+}
+
+// получить значение текущего объекта в контейнере
+template<typename T> T MyCompressedVector<T>::Iterator::value()
+{
+    if (is_end())
+        throw VectorException("Iterator is at the end");
+
+    fillBuffer();
+    return buffer[currentIndex % BLOCK_SIZE];
+}
+
+// указывает ли итератор на конечный фиктивный элемент контейнера, следующий за последним
+// реальным
+template<typename T> bool MyCompressedVector<T>::Iterator::is_end() const
+{
+    return currentIndex >= vector->get_length();
+}
+
+// префиксный инкремент, эквивалентен next()
+template<typename T> typename MyCompressedVector<T>::Iterator &MyCompressedVector<T>::Iterator::operator++()
+{
+    return next();
+}
+
+// оператор разыменования, эквивалентен value()
+template<typename T> T MyCompressedVector<T>::Iterator::operator*()
+{
+    return value();
+}
+
+// оператор сравнения на равенство (по позиции)
+template<typename T> bool MyCompressedVector<T>::Iterator::operator == (const Iterator &b) const
+{
+    return vector == b.vector && currentIndex == b.currentIndex;
+}
+
+// оператор сравнения на неравенство (по позиции)
+template<typename T> bool MyCompressedVector<T>::Iterator::operator != (const Iterator &b) const
+{
+    return !(*this == b);
+}
+
+#endif // MyCompressedVector_H
@@ -0,0 +1,263 @@
+#ifndef MyConcurrentVector_H
+#define MyConcurrentVector_H
+
+#include <algorithm>
+#include <atomic>
+#include <climits>
+#include <thread>
+
+#include "MyVector.h"
+#include "VectorException.h"
+
+// Вектор для одновременного добавления элементов из нескольких потоков. Место под элементы
+// резервируется атомарным fetch_add, а сами элементы хранятся в сегментах, размер которых
+// удваивается и которые никогда не перемещаются в памяти. После завершения всех
+// потоков-производителей содержимое собирается в обычный непрерывный MyVector.
+template <typename T> class MyConcurrentVector {
+public:
+    // размер первого сегмента, каждый следующий сегмент вдвое больше предыдущего
+    static const int FIRST_SEGMENT_SIZE = 1024;
+
+private:
+    // сегментов достаточно, чтобы адресовать все неотрицательные значения int
+    static const int MAX_SEGMENTS = 22;
+
+    std::atomic<T*> segments[MAX_SEGMENTS];
+
+    // счётчик зарезервированных позиций вынесен в отдельную строку кэша, чтобы его изменение
+    // не мешало потокам, читающим указатели на сегменты
+    alignas(64) std::atomic<long long> reserved;
+
+    // номер сегмента, в который попадает индекс
+    static int segmentOf(long long index);
+
+    // индекс первого элемента сегмента
+    static long long segmentStart(int segment);
+
+    // размер сегмента
+    static long long segmentSize(int segment);
+
+    // значение указателя на сегмент, пока один из потоков выделяет его память
+    static T *allocatingMark();
+
+    // получить сегмент, выделив его при первом обращении
+    T *ensureSegment(int segment);
+
+    // зарезервировать count подряд идущих позиций, возвращает индекс первой
+    long long reserve(int count);
+
+    // проверяет индекс на соответствие границам вектора
+    void checkBounds(int index) const;
+
+public:
+    // конструктор пустого вектора
+    MyConcurrentVector();
+
+    // копирование и перемещение запрещены: адреса элементов должны оставаться неизменными
+    MyConcurrentVector(const MyConcurrentVector<T> &vector) = delete;
+    MyConcurrentVector<T> &operator =(const MyConcurrentVector<T> &vector) = delete;
+
+    // деструктор
+    ~MyConcurrentVector();
+
+    // добавить элемент в конец, можно вызывать одновременно из нескольких потоков;
+    // возвращает индекс добавленного элемента
+    int push_back(const T &element);
+
+    // добавить все элементы vector подряд одним резервированием, можно вызывать одновременно
+    // из нескольких потоков; возвращает индекс первого добавленного элемента
+    int append(const MyVector<T> &vector);
+
+    // получить количество зарезервированных позиций
+    int get_length() const;
+
+    // получить элемент по индексу; безопасно только для элементов, запись которых завершена
+    T &get_elem(int index);
+
+    // доступ к элементу, аналогично массиву
+    T &operator [](int index);
+
+    // собрать все элементы в непрерывный MyVector; вызывается после завершения производителей
+    MyVector<T> compact() const;
+};
+
+// номер сегмента, в который попадает индекс
+template<typename T> int MyConcurrentVector<T>::segmentOf(long long index)
+{
+    long long block = index / FIRST_SEGMENT_SIZE;
+    int segment = 0;
+    while (block != 0) {
+        block >>= 1;
+        segment++;
+    }
+    return segment;
+}
+
+// индекс первого элемента сегмента
+template<typename T> long long MyConcurrentVector<T>::segmentStart(int segment)
+{
+    return segment == 0 ? 0 : (long long)FIRST_SEGMENT_SIZE << (segment - 1);
+}
+
+// размер сегмента
+template<typename T> long long MyConcurrentVector<T>::segmentSize(int segment)
+{
+    return segment == 0 ? FIRST_SEGMENT_SIZE : (long long)FIRST_SEGMENT_SIZE << (segment - 1);
+}
+
+// значение указателя на сегмент, пока один из потоков выделяет его память
+template<typename T> T *MyConcurrentVector<T>::allocatingMark()
+{
+    static char mark;
+    return reinterpret_cast<T *>(&mark);
+}
+
+// получить сегмент, выделив его при первом обращении
+template<typename T> T *MyConcurrentVector<T>::ensureSegment(int segment)
+{
+    T *current = segments[segment].load(std::memory_order_acquire);
+    if (current != nullptr && current != allocatingMark())
+        return current;
+
+    // сегмент выделяет и обнуляет только поток, заменивший nullptr меткой; остальные ждут
+    // публикации, а не выделяют и освобождают собственную копию (до 2^30 элементов)
+    if (current == nullptr &&
+        segments[segment].compare_exchange_strong(current, allocatingMark(), std::memory_order_acq_rel)) {
+        T *allocated;
+        try {
+            allocated = new T[segmentSize(segment)]{};
+        } catch(...) {
+            segments[segment].store(nullptr, std::memory_order_release);
+            throw;
+        }
+        segments[segment].store(allocated, std::memory_order_release);
+        return allocated;
+    }
+
+    // current содержит значение, помешавшее обмену
+    while (current == allocatingMark()) {
+        std::this_thread::yield();
+        current = segments[segment].load(std::memory_order_acquire);
+    }
+
+    // выделение в другом потоке не удалось - повторить попытку
+    return current != nullptr ? current : ensureSegment(segment);
+}
+
+// зарезервировать count подряд идущих позиций, возвращает индекс первой
+template<typename T> long long MyConcurrentVector<T>::reserve(int count)
+{
+    long long first = reserved.fetch_add(count, std::memory_order_relaxed);
+    if (first + count > INT_MAX) {
+        reserved.fetch_sub(count, std::memory_order_relaxed);
+        throw VectorException("Vector length exceeds maximum");
+    }
+
+    return first;
+}
+
+// проверяет индекс на соответствие границам вектора
+template<typename T> void MyConcurrentVector<T>::checkBounds(int index) const
+{
+    if (index < 0)
+        throw VectorException("Index must be greater than zero");
+
+    if (get_length() <= index)
+        throw VectorException("Index out of range");
+}
+
+// конструктор пустого вектора
+template<typename T> MyConcurrentVector<T>::MyConcurrentVector() :
+    reserved(0)
+{
+    for(int i = 0; i < MAX_SEGMENTS; i++)
+        segments[i].store(nullptr, std::memory_order_relaxed);
+}
+
+// деструктор
+template<typename T> MyConcurrentVector<T>::~MyConcurrentVector()
+{
+    for(int i = 0; i < MAX_SEGMENTS; i++)
+        delete[] segments[i].load(std::memory_order_relaxed);
+}
+
+// добавить элемент в конец, можно вызывать одновременно из нескольких потоков;
+// возвращает индекс добавленного элемента
+template<typename T> int MyConcurrentVector<T>::push_back(const T &element)
+{
+    long long index = reserve(1);
+    int segment = segmentOf(index);
+
+    ensureSegment(segment)[index - segmentStart(segment)] = element;
+    return (int)index;
+}
+
+// добавить все элементы vector подряд одним резервированием, можно вызывать одновременно
+// из нескольких потоков; возвращает индекс первого добавленного элемента
+template<typename T> int MyConcurrentVector<T>::append(const MyVector<T> &vector)
+{
+    int count = vector.get_length();
+    long long first = reserve(count);
+    const T *source = vector.data();
+
+    // зарезервированный диапазон может пересекать границы сегментов
+    long long index = first;
+    while (index < first + count) {
+        int segment = segmentOf(index);
+        T *target = ensureSegment(segment);
+        long long offset = index - segmentStart(segment);
+        long long chunk = std::min(segmentSize(segment) - offset, first + count - index);
+
+        for(long long i = 0; i < chunk; i++)
+            target[offset + i] = source[index - first + i];
+
+        index += chunk;
+    }
+
+    return (int)first;
+}
+
+// получить количество зарезервированных позиций
+template<typename T> int MyConcurrentVector<T>::get_length() const
+{
+    return (int)std::min<long long>(reserved.load(std::memory_order_acquire), INT_MAX);
+}
+
+// получить элемент по индексу; безопасно только для элементов, запись которых завершена
+template<typename T> T &MyConcurrentVector<T>::get_elem(int index)
+{
+    checkBounds(index);
+
+    int segment = segmentOf(index);
+    return ensureSegment(segment)[index - segmentStart(segment)];
+}
+
+// доступ к элементу, аналогично массиву
+template<typename T> T &MyConcurrentVector<T>::operator [](int index)
+{
+    return get_elem(index);
+}
+
+// собрать все элементы в непрерывный MyVector; вызывается после завершения производителей
+template<typename T> MyVector<T> MyConcurrentVector<T>::compact() const
+{
+    int length = get_length();
+    MyVector<T> result(length);
+    T *target = result.data();
+
+    for(int segment = 0; segment < MAX_SEGMENTS && segmentStart(segment) < length; segment++) {
+        const T *source = segments[segment].load(std::memory_order_acquire);
+        if (source == nullptr)
+            continue;
+
+        long long start = segmentStart(segment);
+        long long count = std::min(segmentSize(segment), length - start);
+
+        for(long long i = 0; i < count; i++)
+            target[start + i] = source[i];
+    }
+
+    return result;
+}
+
+#endif // MyConcurrentVector_H
@@ -0,0 +1,442 @@
+#ifndef MyMatrix_H
+#define MyMatrix_H
+
+#include <algorithm>
+#include <climits>
+
+#include "MyVector.h"
+#include "MyVectorAlgorithms.h"
+#include "VectorException.h"
+
+// Плотная матрица, элементы которой хранятся одним непрерывным MyVector по строкам или по
+// столбцам. Умножения разбиты на блоки, помещающиеся в кэш, а внутренние циклы идут по
+// непрерывной памяти без ветвлений, чтобы компилятор их векторизовал.
+template <typename T> class MyMatrix {
+public:
+    // порядок хранения элементов
+    enum Layout {
+        ROW_MAJOR,
+        COLUMN_MAJOR
+    };
+
+    // размеры блоков для умножения матриц: строки A, общая размерность и столбцы B
+    static const int BLOCK_ROWS = 64;
+    static const int BLOCK_INNER = 256;
+    static const int BLOCK_COLUMNS = 512;
+
+private:
+    MyVector<T> storage;
+    int rows;
+    int columns;
+    Layout layout;
+
+    // проверяет размеры матрицы и возвращает количество элементов
+    static int checkedSize(int rows, int columns);
+
+    // проверяет индексы на соответствие границам матрицы
+    void checkBounds(int row, int column) const;
+
+    // смещение элемента в storage
+    int offsetOf(int row, int column) const;
+
+    // умножение блока строк [rowBegin, rowEnd) построчных a (rows x inner) и b (inner x columns)
+    static void multiplyRows(const T *a, const T *b, T *c, int inner, int columns, int rowBegin, int rowEnd);
+
+public:
+    // конструктор матрицы заданного размера, заполненной нулями
+    MyMatrix(int rows, int columns, Layout layout = ROW_MAJOR);
+
+    // получить количество строк
+    int get_rows() const;
+
+    // получить количество столбцов
+    int get_columns() const;
+
+    // получить порядок хранения элементов
+    Layout get_layout() const;
+
+    // получить указатель на непрерывный массив элементов
+    T *data();
+    const T *data() const;
+
+    // изменить элемент матрицы
+    void set_elem(int row, int column, const T &element);
+
+    // получить элемент матрицы
+    T &get_elem(int row, int column);
+
+    // доступ к элементу матрицы
+    T &operator ()(int row, int column);
+
+    // получить копию строки в виде вектора
+    MyVector<T> get_row(int row) const;
+
+    // получить копию столбца в виде вектора
+    MyVector<T> get_column(int column) const;
+
+    // записать вектор в строку
+    void set_row(int row, const MyVector<T> &vector);
+
+    // записать вектор в столбец
+    void set_column(int column, const MyVector<T> &vector);
+
+    // транспонированная матрица с тем же порядком хранения
+    MyMatrix<T> transpose() const;
+
+    // та же матрица в другом порядке хранения
+    MyMatrix<T> to_layout(Layout target) const;
+
+    // произведение матрицы на вектор; threadCount > 1 включает многопоточный режим
+    MyVector<T> multiply(const MyVector<T> &vector, int threadCount = 1) const;
+
+    // произведение матриц; threadCount > 1 включает многопоточный режим
+    MyMatrix<T> multiply(const MyMatrix<T> &matrix, int threadCount = 1) const;
+
+    // перегрузка оператора *, произведение матрицы на вектор
+    template<typename _T> friend MyVector<_T> operator * (const MyMatrix<_T> &matrix, const MyVector<_T> &vector);
+
+    // перегрузка оператора *, произведение матриц
+    template<typename _T> friend MyMatrix<_T> operator * (const MyMatrix<_T> &m1, const MyMatrix<_T> &m2);
+
+    // перегрузка оператора << для вывода матрицы в поток
+    template <class X> friend std::ostream &operator <<(std::ostream &os, const MyMatrix<X> &matrix);
+};
+
+// проверяет размеры матрицы и возвращает количество элементов
+template<typename T> int MyMatrix<T>::checkedSize(int rows, int columns)
+{
+    if (rows < 0 || columns < 0)
+        throw VectorException("Matrix dimensions must be greater or equal zero");
+
+    if (columns != 0 && rows > INT_MAX / columns)
+        throw VectorException("Matrix is too large");
+
+    return rows * columns;
+}
+
+// проверяет индексы на соответствие границам матрицы
+template<typename T> void MyMatrix<T>::checkBounds(int row, int column) const
+{
+    if (row < 0 || column < 0)
+        throw VectorException("Index must be greater than zero");
+
+    if (rows <= row || columns <= column)
+        throw VectorException("Index out of range");
+}
+
+// смещение элемента в storage
+template<typename T> int MyMatrix<T>::offsetOf(int row, int column) const
+{
+    return layout == ROW_MAJOR ? row * columns + column : column * rows + row;
+}
+
+// умножение блока строк [rowBegin, rowEnd) построчных a (rows x inner) и b (inner x columns)
+template<typename T> void MyMatrix<T>::multiplyRows(const T *a, const T *b, T *c, int inner, int columns,
+                                                    int rowBegin, int rowEnd)
+{
+    for(int jj = 0; jj < columns; jj += BLOCK_COLUMNS) {
+        int jEnd = std::min(jj + BLOCK_COLUMNS, columns);
+
+        for(int kk = 0; kk < inner; kk += BLOCK_INNER) {
+            int kEnd = std::min(kk + BLOCK_INNER, inner);
+
+            for(int ii = rowBegin; ii < rowEnd; ii += BLOCK_ROWS) {
+                int iEnd = std::min(ii + BLOCK_ROWS, rowEnd);
+                int i = ii;
+
+                // микроядро: четыре строки C обновляются за одно чтение строки B
+                for(; i + 4 <= iEnd; i += 4) {
+                    T *c0 = c + (long long)i * columns;
+                    T *c1 = c0 + columns;
+                    T *c2 = c1 + columns;
+                    T *c3 = c2 + columns;
+                    for(int k = kk; k < kEnd; k++) {
+                        const T a0 = a[(long long)i * inner + k];
+                        const T a1 = a[(long long)(i + 1) * inner + k];
+                        const T a2 = a[(long long)(i + 2) * inner + k];
+                        const T a3 = a[(long long)(i + 3) * inner + k];
+                        const T *bRow = b + (long long)k * columns;
+                        for(int j = jj; j < jEnd; j++) {
+                            const T value = bRow[j];
+                            c0[j] += a0 * value;
+                            c1[j] += a1 * value;
+                            c2[j] += a2 * value;
+                            c3[j] += a3 * value;
+                        }
+                    }
+                }
+
+                for(; i < iEnd; i++) {
+                    T *cRow = c + (long long)i * columns;
+                    for(int k = kk; k < kEnd; k++) {
+                        const T aValue = a[(long long)i * inner + k];
+                        const T *bRow = b + (long long)k * columns;
+                        for(int j = jj; j < jEnd; j++)
+                            cRow[j] += aValue * bRow[j];
+                    }
+                }
+            }
+        }
+    }
+}
+
+// конструктор матрицы заданного размера, заполненной нулями
+template<typename T> MyMatrix<T>::MyMatrix(int rows, int columns, Layout layout) :
+    storage(checkedSize(rows, columns)), rows(rows), columns(columns), layout(layout)
+{
+}
+
+// получить количество строк
+template<typename T> int MyMatrix<T>::get_rows() const
+{
+    return rows;
+}
+
+// получить количество столбцов
+template<typename T> int MyMatrix<T>::get_columns() const
+{
+    return columns;
+}
+
+// получить порядок хранения элементов
+template<typename T> typename MyMatrix<T>::Layout MyMatrix<T>::get_layout() const
+{
+    return layout;
+}
+
+// получить указатель на непрерывный массив элементов
+template<typename T> T *MyMatrix<T>::data()
+{
+    return storage.data();
+}
+
+template<typename T> const T *MyMatrix<T>::data() const
+{
+    return storage.data();
+}
+
+// изменить элемент матрицы
+template<typename T> void MyMatrix<T>::set_elem(int row, int column, const T &element)
+{
+    checkBounds(row, column);
+    storage.data()[offsetOf(row, column)] = element;
+}
+
+// получить элемент матрицы
+template<typename T> T &MyMatrix<T>::get_elem(int row, int column)
+{
+    checkBounds(row, column);
+    return storage.data()[offsetOf(row, column)];
+}
+
+// доступ к элементу матрицы
+template<typename T> T &MyMatrix<T>::operator ()(int row, int column)
+{
+    return get_elem(row, column);
+}
+
+// получить копию строки в виде вектора
+template<typename T> MyVector<T> MyMatrix<T>::get_row(int row) const
+{
+    checkBounds(row, 0);
+
+    MyVector<T> result(columns);
+    T *target = result.data();
+    const T *source = storage.data();
+    for(int column = 0; column < columns; column++)
+        target[column] = source[offsetOf(row, column)];
+
+    return result;
+}
+
+// получить копию столбца в виде вектора
+template<typename T> MyVector<T> MyMatrix<T>::get_column(int column) const
+{
+    checkBounds(0, column);
+
+    MyVector<T> result(rows);
+    T *target = result.data();
+    const T *source = storage.data();
+    for(int row = 0; row < rows; row++)
+        target[row] = source[offsetOf(row, column)];
+
+    return result;
+}
+
+// записать вектор в строку
+template<typename T> void MyMatrix<T>::set_row(int row, const MyVector<T> &vector)
+{
+    checkBounds(row, 0);
+    if (vector.get_length() != columns)
+        throw VectorException("Matrix dimensions do not match");
+
+    const T *source = vector.data();
+    T *target = storage.data();
+    for(int column = 0; column < columns; column++)
+        target[offsetOf(row, column)] = source[column];
+}
+
+// записать вектор в столбец
+template<typename T> void MyMatrix<T>::set_column(int column, const MyVector<T> &vector)
+{
+    checkBounds(0, column);
+    if (vector.get_length() != rows)
+        throw VectorException("Matrix dimensions do not match");
+
+    const T *source = vector.data();
+    T *target = storage.data();
+    for(int row = 0; row < rows; row++)
+        target[offsetOf(row, column)] = source[row];
+}
+
+// транспонированная матрица с тем же порядком хранения
+template<typename T> MyMatrix<T> MyMatrix<T>::transpose() const
+{
+    // хранение транспонированной матрицы в другом порядке совпадает с исходным хранением,
+    // поэтому достаточно сменить порядок хранения результата
+    MyMatrix<T> swapped(columns, rows, layout == ROW_MAJOR ? COLUMN_MAJOR : ROW_MAJOR);
+    swapped.storage = storage;
+
+    return swapped.to_layout(layout);
+}
+
+// та же матрица в другом порядке хранения
+template<typename T> MyMatrix<T> MyMatrix<T>::to_layout(Layout target) const
+{
+    MyMatrix<T> result(rows, columns, target);
+    if (target == layout) {
+        result.storage = storage;
+        return result;
+    }
+
+    // перестановка идёт квадратными блоками, чтобы и чтение, и запись оставались в кэше
+    const int TILE = 32;
+    const int outer = layout == ROW_MAJOR ? rows : columns;
+    const int inner = layout == ROW_MAJOR ? columns : rows;
+    const T *source = storage.data();
+    T *destination = result.storage.data();
+
+    for(int oo = 0; oo < outer; oo += TILE)
+        for(int ii = 0; ii < inner; ii += TILE)
+            for(int o = oo; o < std::min(oo + TILE, outer); o++)
+                for(int i = ii; i < std::min(ii + TILE, inner); i++)
+                    destination[(long long)i * outer + o] = source[(long long)o * inner + i];
+
+    return result;
+}
+
+// произведение матрицы на вектор; threadCount > 1 включает многопоточный режим
+template<typename T> MyVector<T> MyMatrix<T>::multiply(const MyVector<T> &vector, int threadCount) const
+{
+    if (vector.get_length() != columns)
+        throw VectorException("Matrix dimensions do not match");
+
+    MyVector<T> result(rows);
+    const T *a = storage.data();
+    const T *x = vector.data();
+    T *y = result.data();
+
+    if (layout == ROW_MAJOR) {
+        // скалярное произведение каждой строки на x, четыре независимых аккумулятора
+        MyVectorAlgorithms::detail::runParallel(threadCount, rows, [&](int, int begin, int end) {
+            for(int i = begin; i < end; i++) {
+                const T *row = a + (long long)i * columns;
+                T s0 = T(), s1 = T(), s2 = T(), s3 = T();
+                int j = 0;
+                for(; j + 4 <= columns; j += 4) {
+                    s0 += row[j] * x[j];
+                    s1 += row[j + 1] * x[j + 1];
+                    s2 += row[j + 2] * x[j + 2];
+                    s3 += row[j + 3] * x[j + 3];
+                }
+                for(; j < columns; j++)
+                    s0 += row[j] * x[j];
+                y[i] = (s0 + s1) + (s2 + s3);
+            }
+        });
+    } else {
+        // y += x[j] * столбец j; потоки делят между собой строки, столбцы обходятся блоками
+        MyVectorAlgorithms::detail::runParallel(threadCount, rows, [&](int, int begin, int end) {
+            for(int jj = 0; jj < columns; jj += BLOCK_INNER) {
+                int jEnd = std::min(jj + BLOCK_INNER, columns);
+                for(int j = jj; j < jEnd; j++) {
+                    const T xValue = x[j];
+                    const T *column = a + (long long)j * rows;
+                    for(int i = begin; i < end; i++)
+                        y[i] += xValue * column[i];
+                }
+            }
+        });
+    }
+
+    return result;
+}
+
+// произведение матриц; threadCount > 1 включает многопоточный режим
+template<typename T> MyMatrix<T> MyMatrix<T>::multiply(const MyMatrix<T> &matrix, int threadCount) const
+{
+    if (columns != matrix.rows)
+        throw VectorException("Matrix dimensions do not match");
+
+    // микроядро работает с построчными операндами, постолбцовые переупорядочиваются один раз
+    const T *aData = storage.data();
+    const T *bData = matrix.storage.data();
+    MyMatrix<T> aRows(0, 0), bRows(0, 0);
+    if (layout == COLUMN_MAJOR) {
+        aRows = to_layout(ROW_MAJOR);
+        aData = aRows.storage.data();
+    }
+    if (matrix.layout == COLUMN_MAJOR) {
+        bRows = matrix.to_layout(ROW_MAJOR);
+        bData = bRows.storage.data();
+    }
+
+    MyMatrix<T> result(rows, matrix.columns, ROW_MAJOR);
+    T *cData = result.storage.data();
+    int inner = columns;
+    int resultColumns = matrix.columns;
+
+    // потоки получают непересекающиеся наборы строк результата
+    MyVectorAlgorithms::detail::runParallel(threadCount, rows, [&](int, int begin, int end) {
+        multiplyRows(aData, bData, cData, inner, resultColumns, begin, end);
+    });
+
+    if (layout == ROW_MAJOR)
+        return result;
+
+    return result.to_layout(layout);
+}
+
+// перегрузка оператора *, произведение матрицы на вектор
+template<typename _T> MyVector<_T> operator * (const MyMatrix<_T> &matrix, const MyVector<_T> &vector)
+{
+    return matrix.multiply(vector);
+}
+
+// перегрузка оператора *, произведение матриц
+template<typename _T> MyMatrix<_T> operator * (const MyMatrix<_T> &m1, const MyMatrix<_T> &m2)
+{
+    return m1.multiply(m2);
+}
+
+// перегрузка оператора << для вывода матрицы в поток
+template<typename T> std::ostream &operator <<(std::ostream &os, const MyMatrix<T> &matrix)
+{
+    os << "MyMatrix{rows: " << matrix.rows << ", columns: " << matrix.columns << ", data: [";
+
+    for(int row = 0; row < matrix.rows; row++) {
+        os << "[";
+        for(int column = 0; column < matrix.columns; column++) {
+            os << std::to_string(matrix.storage.data()[matrix.offsetOf(row, column)]);
+            if (column < matrix.columns - 1)
+                os << ", ";
+        }
+        os << "]";
+        if (row < matrix.rows - 1)
+            os << ", ";
+    }
+
+    return os << "]}";
+}
+
+#endif // MyMatrix_H
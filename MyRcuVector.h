@@ -0,0 +1,510 @@
+#ifndef MyRcuVector_H
+#define MyRcuVector_H
+
+#include <algorithm>
+#include <atomic>
+
+#include "MyVector.h"
+#include "VectorException.h"
+
+// Вектор с публикацией версий в стиле RCU (read-copy-update) для одного писателя и многих
+// читателей. Данные разбиты на блоки; писатель изменяет черновик, копируя только затронутые
+// блоки, и публикует его одной атомарной заменой указателя, так что неизменённые блоки
+// разделяются между версиями. Читатель получает согласованный снимок без ожидания: одна
+// запись эпохи в свой слот и одно чтение указателя. Старые версии освобождаются писателем,
+// когда ни один активный читатель не может их видеть (эпохальное освобождение памяти).
+template <typename T> class MyRcuVector {
+public:
+    // максимальное количество одновременно зарегистрированных читателей
+    static const int MAX_READERS = 128;
+
+private:
+    // блок элементов, разделяемый несколькими версиями; счётчик ссылок меняет только писатель
+    struct Block {
+        MyVector<T> elements;
+        int references;
+
+        Block(int length) : elements(length), references(0) {}
+    };
+
+    // опубликованная или черновая версия вектора
+    struct Version {
+        int length;
+        int blockCount;
+        Block **blocks;
+        unsigned long long retireEpoch;
+        Version *nextRetired;
+
+        Version(int length, int blockCount) :
+            length(length), blockCount(blockCount), blocks(new Block*[blockCount]{}),
+            retireEpoch(0), nextRetired(nullptr) {}
+        ~Version() { delete[] blocks; }
+    };
+
+    // слот читателя: эпоха, в которую читатель вошёл в снимок (0 - снимка нет), и число
+    // владельцев - Reader и его активный снимок; слот свободен, когда владельцев нет, поэтому
+    // снимок, переживший Reader, не отдаёт свою эпоху новому читателю. Слоты выровнены по
+    // строке кэша, чтобы читатели не мешали друг другу
+    struct alignas(64) ReaderSlot {
+        std::atomic<unsigned long long> epoch;
+        std::atomic<int> holders;
+    };
+
+    int blockShift;
+    std::atomic<Version*> current;
+    std::atomic<unsigned long long> globalEpoch;
+    ReaderSlot readerSlots[MAX_READERS];
+
+    // состояние писателя
+    Version *draft;
+    unsigned char *draftOwned;
+    Version *retired;
+    int retiredCount;
+
+    // размер блока
+    int blockSize() const;
+
+    // количество элементов в блоке block версии длины length
+    int blockLength(int length, int block) const;
+
+    // проверяет индекс на соответствие границам версии
+    static void checkBounds(const Version *version, int index);
+
+    // освободить версию, уменьшив счётчики ссылок её блоков
+    static void destroyVersion(Version *version);
+
+    // создать черновик, разделяющий все блоки с текущей версией
+    void ensureDraft();
+
+    // опубликовать версию и передать предыдущую на освобождение
+    void replaceCurrent(Version *version);
+
+public:
+    class Reader;
+
+    // согласованный снимок вектора; пока снимок существует, его версия не освобождается.
+    // Снимок может пережить свой Reader (но не MyRcuVector): слот читателя освобождается
+    // только после уничтожения обоих
+    class Snapshot
+    {
+    private:
+        ReaderSlot *slot;
+        const Version *version;
+        int blockShift;
+        int blockMask;
+
+        Snapshot(ReaderSlot *slot, const Version *version, int blockShift);
+        friend class Reader;
+    public:
+        // конструктор перемещения
+        Snapshot(Snapshot &&snapshot);
+
+        // копирование запрещено: снимок связан со слотом читателя
+        Snapshot(const Snapshot &snapshot) = delete;
+        Snapshot &operator =(const Snapshot &snapshot) = delete;
+
+        // деструктор, завершает чтение
+        ~Snapshot();
+
+        // получить размер снимка
+        int get_length() const;
+
+        // получить элемент снимка по индексу
+        const T &get_elem(int index) const;
+
+        // доступ к элементу снимка, аналогично массиву
+        const T &operator [](int index) const;
+
+        // скопировать снимок в обычный MyVector
+        MyVector<T> to_vector() const;
+    };
+
+    // регистрация потока-читателя; каждый поток использует свой объект Reader
+    class Reader
+    {
+    private:
+        MyRcuVector<T> *vector;
+        int slotIndex;
+    public:
+        // конструктор, занимающий свободный слот читателя
+        explicit Reader(MyRcuVector<T> &vector);
+
+        Reader(const Reader &reader) = delete;
+        Reader &operator =(const Reader &reader) = delete;
+
+        // деструктор, освобождающий слот (или передающий его ещё живому снимку)
+        ~Reader();
+
+        // получить снимок текущей версии; одновременно у читателя может быть один снимок
+        Snapshot snapshot();
+    };
+
+    // конструктор, публикующий начальное содержимое; blockSize округляется до степени двойки
+    explicit MyRcuVector(const MyVector<T> &vector, int blockSize = 1024);
+
+    MyRcuVector(const MyRcuVector<T> &vector) = delete;
+    MyRcuVector<T> &operator =(const MyRcuVector<T> &vector) = delete;
+
+    // деструктор; все читатели должны быть завершены
+    ~MyRcuVector();
+
+    // получить длину последней опубликованной версии (для писателя)
+    int get_length() const;
+
+    // получить элемент черновика или текущей версии (для писателя)
+    const T &get_elem(int index) const;
+
+    // изменить элемент черновика; блок копируется при первом изменении после публикации
+    void set_elem(int index, const T &element);
+
+    // опубликовать черновик, после чего новые снимки видят изменения
+    void publish();
+
+    // опубликовать новое содержимое целиком; блоки, совпадающие с текущей версией, разделяются
+    void publish(const MyVector<T> &vector);
+
+    // освободить версии, которые не может видеть ни один активный читатель
+    void reclaim();
+
+    // количество версий, ожидающих освобождения
+    int get_retired_count() const;
+};
+
+// размер блока
+template<typename T> int MyRcuVector<T>::blockSize() const
+{
+    return 1 << blockShift;
+}
+
+// количество элементов в блоке block версии длины length
+template<typename T> int MyRcuVector<T>::blockLength(int length, int block) const
+{
+    return std::min(blockSize(), length - (block << blockShift));
+}
+
+// проверяет индекс на соответствие границам версии
+template<typename T> void MyRcuVector<T>::checkBounds(const Version *version, int index)
+{
+    if (index < 0)
+        throw VectorException("Index must be greater than zero");
+
+    if (version->length <= index)
+        throw VectorException("Index out of range");
+}
+
+// освободить версию, уменьшив счётчики ссылок её блоков
+template<typename T> void MyRcuVector<T>::destroyVersion(Version *version)
+{
+    for(int block = 0; block < version->blockCount; block++)
+        if (--version->blocks[block]->references == 0)
+            delete version->blocks[block];
+
+    delete version;
+}
+
+// создать черновик, разделяющий все блоки с текущей версией
+template<typename T> void MyRcuVector<T>::ensureDraft()
+{
+    if (draft != nullptr)
+        return;
+
+    const Version *published = current.load(std::memory_order_relaxed);
+    draft = new Version(published->length, published->blockCount);
+    draftOwned = new unsigned char[published->blockCount]{};
+
+    for(int block = 0; block < published->blockCount; block++) {
+        draft->blocks[block] = published->blocks[block];
+        draft->blocks[block]->references++;
+    }
+}
+
+// опубликовать версию и передать предыдущую на освобождение
+template<typename T> void MyRcuVector<T>::replaceCurrent(Version *version)
+{
+    Version *previous = current.exchange(version, std::memory_order_seq_cst);
+
+    // читатель, вошедший в эпоху не позже retireEpoch, мог успеть прочитать previous;
+    // вошедшие позже гарантированно видят новую версию
+    previous->retireEpoch = globalEpoch.fetch_add(1, std::memory_order_seq_cst);
+    previous->nextRetired = retired;
+    retired = previous;
+    retiredCount++;
+
+    reclaim();
+}
+
+// конструктор, публикующий начальное содержимое; blockSize округляется до степени двойки
+template<typename T> MyRcuVector<T>::MyRcuVector(const MyVector<T> &vector, int blockSize) :
+    blockShift(0), current(nullptr), globalEpoch(1), draft(nullptr), draftOwned(nullptr),
+    retired(nullptr), retiredCount(0)
+{
+    if (blockSize <= 0)
+        throw VectorException("Block size must be greater than zero");
+
+    while ((1 << blockShift) < blockSize)
+        blockShift++;
+
+    for(int i = 0; i < MAX_READERS; i++) {
+        readerSlots[i].epoch.store(0, std::memory_order_relaxed);
+        readerSlots[i].holders.store(0, std::memory_order_relaxed);
+    }
+
+    int length = vector.get_length();
+    Version *version = new Version(length, (int)(((long long)length + this->blockSize() - 1) >> blockShift));
+    const T *source = vector.data();
+    for(int block = 0; block < version->blockCount; block++) {
+        int count = blockLength(length, block);
+        version->blocks[block] = new Block(count);
+        version->blocks[block]->references = 1;
+        T *target = version->blocks[block]->elements.data();
+        for(int i = 0; i < count; i++)
+            target[i] = source[(block << blockShift) + i];
+    }
+
+    current.store(version, std::memory_order_seq_cst);
+}
+
+// деструктор; все читатели должны быть завершены
+template<typename T> MyRcuVector<T>::~MyRcuVector()
+{
+    if (draft != nullptr) {
+        destroyVersion(draft);
+        delete[] draftOwned;
+    }
+
+    destroyVersion(current.load(std::memory_order_relaxed));
+
+    while (retired != nullptr) {
+        Version *next = retired->nextRetired;
+        destroyVersion(retired);
+        retired = next;
+    }
+}
+
+// получить длину последней опубликованной версии (для писателя)
+template<typename T> int MyRcuVector<T>::get_length() const
+{
+    return current.load(std::memory_order_relaxed)->length;
+}
+
+// получить элемент черновика или текущей версии (для писателя)
+template<typename T> const T &MyRcuVector<T>::get_elem(int index) const
+{
+    const Version *version = draft != nullptr ? draft : current.load(std::memory_order_relaxed);
+    checkBounds(version, index);
+
+    const Block *block = version->blocks[index >> blockShift];
+    return block->elements.data()[index & (blockSize() - 1)];
+}
+
+// изменить элемент черновика; блок копируется при первом изменении после публикации
+template<typename T> void MyRcuVector<T>::set_elem(int index, const T &element)
+{
+    ensureDraft();
+    checkBounds(draft, index);
+
+    int block = index >> blockShift;
+    if (!draftOwned[block]) {
+        Block *shared = draft->blocks[block];
+        Block *copy = new Block(shared->elements.get_length());
+        const T *source = shared->elements.data();
+        T *target = copy->elements.data();
+        for(int i = 0; i < shared->elements.get_length(); i++)
+            target[i] = source[i];
+
+        // разделяемый блок остаётся хотя бы в текущей версии, поэтому счётчик не обнуляется
+        shared->references--;
+        copy->references = 1;
+        draft->blocks[block] = copy;
+        draftOwned[block] = 1;
+    }
+
+    draft->blocks[block]->elements.data()[index & (blockSize() - 1)] = element;
+}
+
+// опубликовать черновик, после чего новые снимки видят изменения
+template<typename T> void MyRcuVector<T>::publish()
+{
+    if (draft == nullptr)
+        return;
+
+    Version *version = draft;
+    draft = nullptr;
+    delete[] draftOwned;
+    draftOwned = nullptr;
+
+    replaceCurrent(version);
+}
+
+// опубликовать новое содержимое целиком; блоки, совпадающие с текущей версией, разделяются
+template<typename T> void MyRcuVector<T>::publish(const MyVector<T> &vector)
+{
+    if (draft != nullptr) {
+        destroyVersion(draft);
+        draft = nullptr;
+        delete[] draftOwned;
+        draftOwned = nullptr;
+    }
+
+    const Version *published = current.load(std::memory_order_relaxed);
+    int length = vector.get_length();
+    Version *version = new Version(length, (int)(((long long)length + blockSize() - 1) >> blockShift));
+    const T *source = vector.data();
+
+    for(int block = 0; block < version->blockCount; block++) {
+        int count = blockLength(length, block);
+        const T *blockSource = source + (block << blockShift);
+
+        if (block < published->blockCount && published->blocks[block]->elements.get_length() == count) {
+            Block *shared = published->blocks[block];
+            const T *sharedData = shared->elements.data();
+            bool equal = true;
+            for(int i = 0; i < count && equal; i++)
+                equal = sharedData[i] == blockSource[i];
+
+            if (equal) {
+                shared->references++;
+                version->blocks[block] = shared;
+                continue;
+            }
+        }
+
+        Block *created = new Block(count);
+        created->references = 1;
+        T *target = created->elements.data();
+        for(int i = 0; i < count; i++)
+            target[i] = blockSource[i];
+        version->blocks[block] = created;
+    }
+
+    replaceCurrent(version);
+}
+
+// освободить версии, которые не может видеть ни один активный читатель
+template<typename T> void MyRcuVector<T>::reclaim()
+{
+    unsigned long long minimumEpoch = ~0ULL;
+    for(int i = 0; i < MAX_READERS; i++) {
+        unsigned long long epoch = readerSlots[i].epoch.load(std::memory_order_seq_cst);
+        if (epoch != 0)
+            minimumEpoch = std::min(minimumEpoch, epoch);
+    }
+
+    Version **link = &retired;
+    while (*link != nullptr) {
+        Version *version = *link;
+        if (version->retireEpoch < minimumEpoch) {
+            *link = version->nextRetired;
+            destroyVersion(version);
+            retiredCount--;
+        } else {
+            link = &version->nextRetired;
+        }
+    }
+}
+
+// количество версий, ожидающих освобождения
+template<typename T> int MyRcuVector<T>::get_retired_count() const
+{
+    return retiredCount;
+}
+
+
+// конструктор, занимающий свободный слот читателя
+template<typename T> MyRcuVector<T>::Reader::Reader(MyRcuVector<T> &vector) :
+    vector(&vector), slotIndex(-1)
+{
+    for(int i = 0; i < MAX_READERS; i++) {
+        int expected = 0;
+        if (vector.readerSlots[i].holders.compare_exchange_strong(expected, 1, std::memory_order_acquire)) {
+            slotIndex = i;
+            return;
+        }
+    }
+
+    throw VectorException("Too many readers");
+}
+
+// деструктор, освобождающий слот; эпоху активного снимка сбросит сам снимок
+template<typename T> MyRcuVector<T>::Reader::~Reader()
+{
+    vector->readerSlots[slotIndex].holders.fetch_sub(1, std::memory_order_release);
+}
+
+// получить снимок текущей версии; одновременно у читателя может быть один снимок
+template<typename T> typename MyRcuVector<T>::Snapshot MyRcuVector<T>::Reader::snapshot()
+{
+    ReaderSlot &slot = vector->readerSlots[slotIndex];
+    if (slot.epoch.load(std::memory_order_relaxed) != 0)
+        throw VectorException("Reader already holds a snapshot");
+
+    // сначала объявляется эпоха, затем читается указатель: писатель, увидевший эту эпоху,
+    // не освободит версию, которую читатель может прочитать
+    slot.holders.fetch_add(1, std::memory_order_relaxed);
+    slot.epoch.store(vector->globalEpoch.load(std::memory_order_seq_cst), std::memory_order_seq_cst);
+    const Version *version = vector->current.load(std::memory_order_seq_cst);
+
+    return Snapshot(&slot, version, vector->blockShift);
+}
+
+
+// конструктор снимка, вызывается из Reader::snapshot
+template<typename T> MyRcuVector<T>::Snapshot::Snapshot(ReaderSlot *slot, const Version *version, int blockShift) :
+    slot(slot), version(version), blockShift(blockShift), blockMask((1 << blockShift) - 1)
+{
+}
+
+// конструктор перемещения
+template<typename T> MyRcuVector<T>::Snapshot::Snapshot(Snapshot &&snapshot) :
+    slot(snapshot.slot), version(snapshot.version), blockShift(snapshot.blockShift), blockMask(snapshot.blockMask)
+{
+    snapshot.slot = nullptr;
+}
+
+// деструктор, завершает чтение и освобождает слот, если Reader уже уничтожен
+template<typename T> MyRcuVector<T>::Snapshot::~Snapshot()
+{
+    if (slot != nullptr) {
+        slot->epoch.store(0, std::memory_order_seq_cst);
+        slot->holders.fetch_sub(1, std::memory_order_release);
+    }
+}
+
+// получить размер снимка
+template<typename T> int MyRcuVector<T>::Snapshot::get_length() const
+{
+    return version->length;
+}
+
+// получить элемент снимка по индексу
+template<typename T> const T &MyRcuVector<T>::Snapshot::get_elem(int index) const
+{
+    checkBounds(version, index);
+
+    const Block *block = version->blocks[index >> blockShift];
+    return block->elements.data()[index & blockMask];
+}
+
+// доступ к элементу снимка, аналогично массиву
+template<typename T> const T &MyRcuVector<T>::Snapshot::operator [](int index) const
+{
+    return get_elem(index);
+}
+
+// скопировать снимок в обычный MyVector
+template<typename T> MyVector<T> MyRcuVector<T>::Snapshot::to_vector() const
+{
+    MyVector<T> result(version->length);
+    T *target = result.data();
+
+    for(int block = 0; block < version->blockCount; block++) {
+        const MyVector<T> &elements = version->blocks[block]->elements;
+        const T *source = elements.data();
+        for(int i = 0; i < elements.get_length(); i++)
+            target[(block << blockShift) + i] = source[i];
+    }
+
+    return result;
+}
+
+#endif // MyRcuVector_H
@@ -0,0 +1,4 @@
+#include "MyVector.h"
+
+// явные инстанцирования MyVector для int, long, float и double
+MYVECTOR_INSTANTIATE_COMMON_TYPES()
@@ -1,18 +1,100 @@
 #ifndef MyVector_H
 #define MyVector_H
 
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+#include <functional>
 #include <initializer_list>
 #include <iostream>
+#include <limits>
+#include <mutex>
+#include <type_traits>
+#include <utility>
 
 #include "VectorException.h"
 
+#if defined(__AVX2__) || defined(__AVX512F__)
+#include <immintrin.h>
+#endif
+
+// программная предвыборка адреса в кэш; на компиляторах без __builtin_prefetch ничего не делает
+#if defined(__GNUC__) || defined(__clang__)
+#define MYVECTOR_PREFETCH_READ(address) __builtin_prefetch((address), 0)
+#define MYVECTOR_PREFETCH_WRITE(address) __builtin_prefetch((address), 1)
+#else
+#define MYVECTOR_PREFETCH_READ(address) ((void)0)
+#define MYVECTOR_PREFETCH_WRITE(address) ((void)0)
+#endif
+
 template <typename T> class MyVector {
 private:
     T *internalArray;
     int internalArrayLength;
 
     // проверяет индекс на соответствие границам массива
-    void checkBounds(int index);
+    void checkBounds(int index) const;
+
+    // проверяет, что длина vector совпадает с длиной this
+    void checkLength(const MyVector<T> &vector) const;
+
+    // a * b + c одной инструкцией FMA, если она есть у процессора
+    static T fusedMultiplyAdd(const T &a, const T &b, const T &c);
+
+    // на сколько элементов вперёд gather и scatter выполняют предвыборку
+    static const int PREFETCH_DISTANCE = 16;
+
+    // проверяет за один проход, что все индексы попадают в границы массива
+    void checkIndices(const MyVector<int> &indices) const;
+
+    // out[i] = source[indices[i]] для i из [0, count), с AVX2/AVX-512 gather где возможно
+    static void gatherKernel(const T *source, const int *indices, T *out, int count);
+
+    // номер первого несовпадающего элемента a и b или length, если все элементы равны
+    static int mismatch(const T *a, const T *b, int length);
+
+    // кэш агрегатов: частичные суммы, суммы квадратов, минимумы и максимумы блоков хранятся
+    // в листьях дерева отрезков, внутренние узлы объединяют агрегаты своих потомков.
+    // lock сериализует обновление кэша константными запросами из разных потоков
+    struct AggregateCache {
+        std::mutex lock;
+        int blockShift;
+        int blockCount;
+        bool allDirty;
+        int dirtyCount;
+        int *dirtyBlocks;
+        unsigned char *dirtyFlags;
+        T *sums;
+        double *squares;
+        T *minimums;
+        T *maximums;
+
+        AggregateCache(int blockShift, int length);
+        AggregateCache(const AggregateCache &cache) = delete;
+        AggregateCache &operator =(const AggregateCache &cache) = delete;
+        ~AggregateCache();
+    };
+
+    AggregateCache *aggregateCache = nullptr;
+
+    // отметить блок, содержащий index, как изменённый
+    void markDirty(int index) const;
+
+    // отметить весь вектор как изменённый
+    void markAllDirty() const;
+
+    // пересоздать кэш после изменения длины вектора
+    void resetAggregateCache();
+
+    // пересчитать агрегаты изменённых блоков и их предков в дереве
+    void refreshAggregates() const;
+
+    // пересчитать агрегаты одного блока
+    void recomputeBlock(int block) const;
+
+    // объединить агрегаты потомков внутреннего узла дерева
+    void combineNode(int node) const;
 public:
     class Iterator
     {
@@ -66,20 +148,40 @@ public:
     // перегрузка оператора присваивания
     MyVector<T>& operator =(const MyVector<T>& srcVector);
 
+    // присваивание перемещением: массивы this и srcVector меняются местами без копирования,
+    // кэш агрегатов каждого из них (если включён) перестраивается под новую длину
+    MyVector<T>& operator =(MyVector<T>&& srcVector);
+
     // получить текущий размер
     int get_length() const;
 
     // изменить элемент вектора по индексу
     void set_elem(int index,const T &element);
 
-    // получить элемент списка по индексу
+    // получить элемент списка по индексу. Неконстантная версия помечает блок элемента
+    // изменённым в момент вызова: писать через ссылку после sum/norm/min_elem/max_elem нельзя,
+    // такая запись в кэш агрегатов не попадёт
     T& get_elem(int index);
+    const T& get_elem(int index) const;
 
     // создать новый массив, в который необходимо записать все элементы вектора
     T* to_array();
 
-    // доступ к элементу, аналогично массиву
+    // получить указатель на внутренний массив элементов (без копирования). Каждый вызов
+    // неконстантной версии сбрасывает кэш агрегатов целиком, поэтому указатель нужно
+    // запрашивать заново после каждого агрегатного запроса, если через него пишут
+    T* data();
+    const T* data() const;
+
+    // собрать элементы по списку индексов: out[i] = this[indices[i]]
+    void gather(const MyVector<int> &indices, MyVector<T> &out) const;
+
+    // записать элементы по списку индексов: this[indices[i]] = values[i]
+    void scatter(const MyVector<int> &indices, const MyVector<T> &values);
+
+    // доступ к элементу, аналогично массиву; для ссылки действует то же ограничение, что и для get_elem
     T& operator [](int index);
+    const T& operator [](int index) const;
 
     // перегрузка оператора << для вывода класса в поток (cout к примеру)
     template <class X> friend std::ostream &operator <<(std::ostream &os, const MyVector<X> &list);
@@ -96,6 +198,52 @@ public:
     // перегрузка оператора /=, каждый элемент this делится на val
     MyVector<T>& operator /=(const T& value);
 
+    // this = a * x + this, каждый элемент читается и записывается один раз
+    MyVector<T>& axpy(const T &a, const MyVector<T> &x);
+
+    // this = a * x + b * this
+    MyVector<T>& axpby(const T &a, const MyVector<T> &x, const T &b);
+
+    // поэлементное умножение: this[i] *= x[i]
+    MyVector<T>& hadamard(const MyVector<T> &x);
+
+    // поэлементное деление: this[i] /= x[i]
+    MyVector<T>& hadamard_divide(const MyVector<T> &x);
+
+    // this = a * b + c поэлементно
+    MyVector<T>& fma(const MyVector<T> &a, const MyVector<T> &b, const MyVector<T> &c);
+
+    // ограничить каждый элемент отрезком [low, high]
+    MyVector<T>& clamp(const T &low, const T &high);
+
+    // заменить каждый элемент его модулем; для знаковых целых модуль наименьшего значения
+    // не представим и заменяется наибольшим (насыщение)
+    MyVector<T>& abs();
+
+    // включить кэширование агрегатов: вектор делится на блоки по blockSize элементов
+    // (округляется вверх до степени двойки), запись через set_elem, get_elem, operator [],
+    // составные операторы и остальные изменяющие методы помечает блоки как изменённые, и
+    // запросы sum, norm, min_elem, max_elem пересчитывают только эти блоки
+    void enable_aggregate_cache(int blockSize = 4096);
+
+    // выключить кэширование агрегатов
+    void disable_aggregate_cache();
+
+    // включено ли кэширование агрегатов
+    bool is_aggregate_cache_enabled() const;
+
+    // сумма элементов
+    T sum() const;
+
+    // евклидова норма вектора
+    double norm() const;
+
+    // минимальный элемент
+    T min_elem() const;
+
+    // максимальный элемент
+    T max_elem() const;
+
     // перегрузка оператора += к v1 добавлется v2
     template<typename _T> friend MyVector<_T> operator +(const MyVector<_T> &v1, const MyVector<_T> &v2);
 
@@ -108,6 +256,22 @@ public:
     // перегрузка оператора /, каждый элемент v1 делится на val
     template<typename _T, typename __T> friend MyVector<_T> operator / (const MyVector<_T> &v1, const __T &value);
 
+    // поэлементное сравнение на равенство; для вещественных типов по правилам IEEE 754
+    // (0.0 == -0.0, NaN не равен ничему)
+    template<typename _T> friend bool operator ==(const MyVector<_T> &v1, const MyVector<_T> &v2);
+    template<typename _T> friend bool operator !=(const MyVector<_T> &v1, const MyVector<_T> &v2);
+
+    // лексикографическое сравнение: решает первый несовпадающий элемент, а при совпадении
+    // общей части - длина
+    template<typename _T> friend bool operator <(const MyVector<_T> &v1, const MyVector<_T> &v2);
+    template<typename _T> friend bool operator <=(const MyVector<_T> &v1, const MyVector<_T> &v2);
+    template<typename _T> friend bool operator >(const MyVector<_T> &v1, const MyVector<_T> &v2);
+    template<typename _T> friend bool operator >=(const MyVector<_T> &v1, const MyVector<_T> &v2);
+
+    // хеш содержимого (XXH64 с начальным значением seed), согласованный с operator ==:
+    // равные векторы дают равные хеши
+    unsigned long long hash(unsigned long long seed = 0) const;
+
     // метод получения итератора на начало вектора (первый элемент)
     Iterator iterator_begin();
 
@@ -115,8 +279,165 @@ public:
     Iterator iterator_end();
 };
 
+// Потоковый некриптографический хеш XXH64: данные можно подавать частями, результат равен
+// хешу их конкатенации. Четыре независимые 64-битные полосы обрабатывают по 32 байта за шаг,
+// поэтому умножения разных полос выполняются процессором параллельно.
+class MyVectorHasher {
+private:
+    static const unsigned long long PRIME1 = 11400714785074694791ULL;
+    static const unsigned long long PRIME2 = 14029467366897019727ULL;
+    static const unsigned long long PRIME3 = 1609587929392839161ULL;
+    static const unsigned long long PRIME4 = 9650029242287828579ULL;
+    static const unsigned long long PRIME5 = 2870177450012600261ULL;
+
+    unsigned long long seed;
+    unsigned long long lanes[4];
+    unsigned long long totalLength;
+    unsigned char buffer[32];
+    int bufferSize;
+
+    static unsigned long long rotate(unsigned long long value, int bits)
+    {
+        return (value << bits) | (value >> (64 - bits));
+    }
+
+    static unsigned long long laneRound(unsigned long long lane, unsigned long long input)
+    {
+        return rotate(lane + input * PRIME2, 31) * PRIME1;
+    }
+
+    static unsigned long long read64(const unsigned char *bytes)
+    {
+        unsigned long long value;
+        std::memcpy(&value, bytes, sizeof(value));
+        return value;
+    }
+
+    static unsigned long long read32(const unsigned char *bytes)
+    {
+        unsigned int value;
+        std::memcpy(&value, bytes, sizeof(value));
+        return value;
+    }
+
+    // обработать 32-байтные полосы, возвращает количество обработанных байт
+    size_t consume(const unsigned char *bytes, size_t length)
+    {
+        size_t offset = 0;
+        for(; offset + 32 <= length; offset += 32) {
+            lanes[0] = laneRound(lanes[0], read64(bytes + offset));
+            lanes[1] = laneRound(lanes[1], read64(bytes + offset + 8));
+            lanes[2] = laneRound(lanes[2], read64(bytes + offset + 16));
+            lanes[3] = laneRound(lanes[3], read64(bytes + offset + 24));
+        }
+        return offset;
+    }
+
+public:
+    explicit MyVectorHasher(unsigned long long seed = 0)
+    {
+        reset(seed);
+    }
+
+    // начать вычисление заново
+    void reset(unsigned long long seed = 0)
+    {
+        this->seed = seed;
+        lanes[0] = seed + PRIME1 + PRIME2;
+        lanes[1] = seed + PRIME2;
+        lanes[2] = seed;
+        lanes[3] = seed - PRIME1;
+        totalLength = 0;
+        bufferSize = 0;
+    }
+
+    // добавить length байт
+    void update(const void *data, size_t length)
+    {
+        const unsigned char *bytes = static_cast<const unsigned char *>(data);
+        totalLength += length;
+
+        if (bufferSize > 0) {
+            size_t fill = std::min(length, (size_t)(32 - bufferSize));
+            std::memcpy(buffer + bufferSize, bytes, fill);
+            bufferSize += (int)fill;
+            bytes += fill;
+            length -= fill;
+            if (bufferSize < 32)
+                return;
+
+            consume(buffer, 32);
+            bufferSize = 0;
+        }
+
+        size_t done = consume(bytes, length);
+        std::memcpy(buffer, bytes + done, length - done);
+        bufferSize = (int)(length - done);
+    }
+
+    // добавить элементы вектора; у вещественных -0.0 заменяется на 0.0, чтобы хеш был
+    // согласован с operator ==
+    template<typename T> void update(const MyVector<T> &vector);
+
+    // хеш всех добавленных данных; добавление можно продолжать и после вызова
+    unsigned long long digest() const
+    {
+        unsigned long long result;
+        if (totalLength >= 32) {
+            result = rotate(lanes[0], 1) + rotate(lanes[1], 7) + rotate(lanes[2], 12) + rotate(lanes[3], 18);
+            for(int i = 0; i < 4; i++)
+                result = (result ^ laneRound(0, lanes[i])) * PRIME1 + PRIME4;
+        } else {
+            result = seed + PRIME5;
+        }
+        result += totalLength;
+
+        int offset = 0;
+        for(; offset + 8 <= bufferSize; offset += 8)
+            result = rotate(result ^ laneRound(0, read64(buffer + offset)), 27) * PRIME1 + PRIME4;
+        if (offset + 4 <= bufferSize) {
+            result = rotate(result ^ (read32(buffer + offset) * PRIME1), 23) * PRIME2 + PRIME3;
+            offset += 4;
+        }
+        for(; offset < bufferSize; offset++)
+            result = rotate(result ^ (buffer[offset] * PRIME5), 11) * PRIME1;
+
+        result ^= result >> 33;
+        result *= PRIME2;
+        result ^= result >> 29;
+        result *= PRIME3;
+        result ^= result >> 32;
+        return result;
+    }
+};
+
+// добавить элементы вектора
+template<typename T> void MyVectorHasher::update(const MyVector<T> &vector)
+{
+    static_assert(std::is_arithmetic<T>::value, "Only vectors of arithmetic types can be hashed");
+    // у long double часть из sizeof байт - неопределённое заполнение, равные значения дали бы разные хеши
+    static_assert(!std::is_same<typename std::remove_cv<T>::type, long double>::value,
+                  "Vectors of long double cannot be hashed");
+
+    const T *data = vector.data();
+    int length = vector.get_length();
+    if constexpr (!std::is_floating_point<T>::value) {
+        update(data, (size_t)length * sizeof(T));
+    } else {
+        // нормализация идёт пачками через локальный буфер; цикл без ветвлений векторизуется
+        const int BATCH = 256;
+        T canonical[BATCH];
+        for(int begin = 0; begin < length; begin += BATCH) {
+            int size = std::min(BATCH, length - begin);
+            for(int i = 0; i < size; i++)
+                canonical[i] = data[begin + i] == T() ? T() : data[begin + i];
+            update(canonical, (size_t)size * sizeof(T));
+        }
+    }
+}
+
 // проверяет индекс на соответствие границам массива
-template<typename T> void MyVector<T>::checkBounds(int index) {
+template<typename T> void MyVector<T>::checkBounds(int index) const {
     if (index < 0)
         throw VectorException("Index must be greater than zero");
 
@@ -124,6 +445,269 @@ template<typename T> void MyVector<T>::checkBounds(int index) {
         throw VectorException("Index out of range");
 }
 
+// проверяет, что длина vector совпадает с длиной this
+template<typename T> void MyVector<T>::checkLength(const MyVector<T> &vector) const
+{
+    if (internalArrayLength != vector.internalArrayLength)
+        throw VectorException("Vector lengths must be equal");
+}
+
+// a * b + c одной инструкцией FMA, если она есть у процессора
+template<typename T> T MyVector<T>::fusedMultiplyAdd(const T &a, const T &b, const T &c)
+{
+    // std::fma вызывается только при аппаратной поддержке, иначе она эмулируется медленно
+#ifdef FP_FAST_FMAF
+    if constexpr (std::is_same<T, float>::value)
+        return std::fma(a, b, c);
+#endif
+#ifdef FP_FAST_FMA
+    if constexpr (std::is_same<T, double>::value)
+        return std::fma(a, b, c);
+#endif
+    return a * b + c;
+}
+
+// проверяет за один проход, что все индексы попадают в границы массива
+template<typename T> void MyVector<T>::checkIndices(const MyVector<int> &indices) const
+{
+    // минимум и максимум считаются без ветвлений, поэтому цикл векторизуется
+    const int *index = indices.data();
+    int minimum = 0;
+    int maximum = -1;
+    if (indices.get_length() > 0)
+        minimum = maximum = index[0];
+
+    for(int i = 1; i < indices.get_length(); i++) {
+        minimum = std::min(minimum, index[i]);
+        maximum = std::max(maximum, index[i]);
+    }
+
+    if (minimum < 0)
+        throw VectorException("Index must be greater than zero");
+
+    if (internalArrayLength <= maximum)
+        throw VectorException("Index out of range");
+}
+
+// номер первого несовпадающего элемента a и b или length, если все элементы равны
+template<typename T> int MyVector<T>::mismatch(const T *a, const T *b, int length)
+{
+    int i = 0;
+
+#if defined(__AVX2__)
+    // по 32 байта за сравнение; найденный блок с различием дорабатывается циклом ниже
+    if constexpr (std::is_same<T, float>::value) {
+        for(; i + 8 <= length; i += 8) {
+            __m256 equal = _mm256_cmp_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i), _CMP_EQ_OQ);
+            if (_mm256_movemask_ps(equal) != 0xff)
+                break;
+        }
+    } else if constexpr (std::is_same<T, double>::value) {
+        for(; i + 4 <= length; i += 4) {
+            __m256d equal = _mm256_cmp_pd(_mm256_loadu_pd(a + i), _mm256_loadu_pd(b + i), _CMP_EQ_OQ);
+            if (_mm256_movemask_pd(equal) != 0xf)
+                break;
+        }
+    } else if constexpr (std::is_integral<T>::value && (sizeof(T) == 4 || sizeof(T) == 8)) {
+        const int step = 32 / sizeof(T);
+        for(; i + step <= length; i += step) {
+            __m256i left = _mm256_loadu_si256((const __m256i *)(a + i));
+            __m256i right = _mm256_loadu_si256((const __m256i *)(b + i));
+            __m256i equal = sizeof(T) == 4 ? _mm256_cmpeq_epi32(left, right) : _mm256_cmpeq_epi64(left, right);
+            if (_mm256_movemask_epi8(equal) != -1)
+                break;
+        }
+    }
+#endif
+
+    // блоки сравниваются без раннего выхода внутри блока, чтобы цикл векторизовался
+    const int BLOCK = 64;
+    for(; i < length; i += BLOCK) {
+        int end = length - i < BLOCK ? length : i + BLOCK;
+        bool differ = false;
+        for(int j = i; j < end; j++)
+            differ |= !(a[j] == b[j]);
+
+        if (differ)
+            for(int j = i; ; j++)
+                if (!(a[j] == b[j]))
+                    return j;
+    }
+
+    return length;
+}
+
+// out[i] = source[indices[i]] для i из [0, count), с AVX2/AVX-512 gather где возможно
+template<typename T> void MyVector<T>::gatherKernel(const T *source, const int *indices, T *out, int count)
+{
+    int i = 0;
+
+#if defined(__AVX512F__)
+    // маскированные варианты с явным нулевым источником: у немаскированных источник не
+    // инициализирован, и gcc выдаёт -Wmaybe-uninitialized внутри avx512fintrin.h
+    if constexpr (std::is_arithmetic<T>::value && sizeof(T) == 4) {
+        for(; i + 16 <= count; i += 16) {
+            for(int p = 0; p < 16 && i + PREFETCH_DISTANCE + p < count; p++)
+                MYVECTOR_PREFETCH_READ(source + indices[i + PREFETCH_DISTANCE + p]);
+            __m512i index = _mm512_loadu_si512((const void *)(indices + i));
+            __m512i values = _mm512_mask_i32gather_epi32(_mm512_setzero_si512(), (__mmask16)0xffff, index,
+                                                          (const void *)source, 4);
+            _mm512_storeu_si512((void *)(out + i), values);
+        }
+    } else if constexpr (std::is_arithmetic<T>::value && sizeof(T) == 8) {
+        for(; i + 8 <= count; i += 8) {
+            for(int p = 0; p < 8 && i + PREFETCH_DISTANCE + p < count; p++)
+                MYVECTOR_PREFETCH_READ(source + indices[i + PREFETCH_DISTANCE + p]);
+            __m256i index = _mm256_loadu_si256((const __m256i *)(indices + i));
+            __m512i values = _mm512_mask_i32gather_epi64(_mm512_setzero_si512(), (__mmask8)0xff, index,
+                                                          (const void *)source, 8);
+            _mm512_storeu_si512((void *)(out + i), values);
+        }
+    }
+#elif defined(__AVX2__)
+    if constexpr (std::is_arithmetic<T>::value && sizeof(T) == 4) {
+        for(; i + 8 <= count; i += 8) {
+            for(int p = 0; p < 8 && i + PREFETCH_DISTANCE + p < count; p++)
+                MYVECTOR_PREFETCH_READ(source + indices[i + PREFETCH_DISTANCE + p]);
+            __m256i index = _mm256_loadu_si256((const __m256i *)(indices + i));
+            __m256i values = _mm256_i32gather_epi32((const int *)source, index, 4);
+            _mm256_storeu_si256((__m256i *)(out + i), values);
+        }
+    } else if constexpr (std::is_arithmetic<T>::value && sizeof(T) == 8) {
+        for(; i + 4 <= count; i += 4) {
+            for(int p = 0; p < 4 && i + PREFETCH_DISTANCE + p < count; p++)
+                MYVECTOR_PREFETCH_READ(source + indices[i + PREFETCH_DISTANCE + p]);
+            __m128i index = _mm_loadu_si128((const __m128i *)(indices + i));
+            __m256i values = _mm256_i32gather_epi64((const long long *)source, index, 8);
+            _mm256_storeu_si256((__m256i *)(out + i), values);
+        }
+    }
+#endif
+
+    for(; i < count; i++) {
+        if (i + PREFETCH_DISTANCE < count)
+            MYVECTOR_PREFETCH_READ(source + indices[i + PREFETCH_DISTANCE]);
+        out[i] = source[indices[i]];
+    }
+}
+
+// кэш агрегатов для вектора длины length с блоками по 2^blockShift элементов
+template<typename T> MyVector<T>::AggregateCache::AggregateCache(int blockShift, int length) :
+    blockShift(blockShift),
+    blockCount((int)(((long long)length + (1LL << blockShift) - 1) >> blockShift)),
+    allDirty(true), dirtyCount(0)
+{
+    dirtyBlocks = new int[blockCount];
+    dirtyFlags = new unsigned char[blockCount]{};
+    sums = new T[2 * blockCount]{};
+    squares = new double[2 * blockCount]{};
+    minimums = new T[2 * blockCount]{};
+    maximums = new T[2 * blockCount]{};
+}
+
+template<typename T> MyVector<T>::AggregateCache::~AggregateCache()
+{
+    delete[] dirtyBlocks;
+    delete[] dirtyFlags;
+    delete[] sums;
+    delete[] squares;
+    delete[] minimums;
+    delete[] maximums;
+}
+
+// отметить блок, содержащий index, как изменённый
+template<typename T> void MyVector<T>::markDirty(int index) const
+{
+    if (aggregateCache == nullptr || aggregateCache->allDirty)
+        return;
+
+    int block = index >> aggregateCache->blockShift;
+    if (!aggregateCache->dirtyFlags[block]) {
+        aggregateCache->dirtyFlags[block] = 1;
+        aggregateCache->dirtyBlocks[aggregateCache->dirtyCount++] = block;
+    }
+}
+
+// отметить весь вектор как изменённый
+template<typename T> void MyVector<T>::markAllDirty() const
+{
+    if (aggregateCache != nullptr)
+        aggregateCache->allDirty = true;
+}
+
+// пересоздать кэш после изменения длины вектора
+template<typename T> void MyVector<T>::resetAggregateCache()
+{
+    if (aggregateCache == nullptr)
+        return;
+
+    int blockShift = aggregateCache->blockShift;
+    delete aggregateCache;
+    aggregateCache = new AggregateCache(blockShift, internalArrayLength);
+}
+
+// пересчитать агрегаты одного блока
+template<typename T> void MyVector<T>::recomputeBlock(int block) const
+{
+    int begin = block << aggregateCache->blockShift;
+    int end = (int)std::min<long long>((long long)begin + (1LL << aggregateCache->blockShift), internalArrayLength);
+
+    T sum = T();
+    double squares = 0;
+    T minimum = internalArray[begin];
+    T maximum = internalArray[begin];
+    for(int i = begin; i < end; i++) {
+        T value = internalArray[i];
+        sum += value;
+        squares += (double)value * (double)value;
+        minimum = (value < minimum) ? value : minimum;
+        maximum = (maximum < value) ? value : maximum;
+    }
+
+    int leaf = aggregateCache->blockCount + block;
+    aggregateCache->sums[leaf] = sum;
+    aggregateCache->squares[leaf] = squares;
+    aggregateCache->minimums[leaf] = minimum;
+    aggregateCache->maximums[leaf] = maximum;
+}
+
+// объединить агрегаты потомков внутреннего узла дерева
+template<typename T> void MyVector<T>::combineNode(int node) const
+{
+    AggregateCache &cache = *aggregateCache;
+    int left = 2 * node, right = 2 * node + 1;
+
+    cache.sums[node] = cache.sums[left] + cache.sums[right];
+    cache.squares[node] = cache.squares[left] + cache.squares[right];
+    cache.minimums[node] = (cache.minimums[right] < cache.minimums[left]) ? cache.minimums[right] : cache.minimums[left];
+    cache.maximums[node] = (cache.maximums[left] < cache.maximums[right]) ? cache.maximums[right] : cache.maximums[left];
+}
+
+// пересчитать агрегаты изменённых блоков и их предков в дереве
+template<typename T> void MyVector<T>::refreshAggregates() const
+{
+    AggregateCache &cache = *aggregateCache;
+
+    if (cache.allDirty) {
+        for(int block = 0; block < cache.blockCount; block++)
+            recomputeBlock(block);
+        for(int node = cache.blockCount - 1; node >= 1; node--)
+            combineNode(node);
+    } else {
+        // каждый изменённый блок обновляет только путь от своего листа до корня
+        for(int i = 0; i < cache.dirtyCount; i++) {
+            int block = cache.dirtyBlocks[i];
+            recomputeBlock(block);
+            for(int node = (cache.blockCount + block) >> 1; node >= 1; node >>= 1)
+                combineNode(node);
+        }
+    }
+
+    for(int i = 0; i < cache.dirtyCount; i++)
+        cache.dirtyFlags[cache.dirtyBlocks[i]] = 0;
+    cache.dirtyCount = 0;
+    cache.allDirty = false;
+}
 
 // конструктор с указанием размерности
 template<typename T> MyVector<T>::MyVector(int length)
@@ -149,8 +733,10 @@ template<typename T> MyVector<T>::MyVector(MyVector<T> &&vector)
 {
     internalArray = vector.internalArray;
     internalArrayLength = vector.internalArrayLength;
+    aggregateCache = vector.aggregateCache;
     vector.internalArrayLength = 0;
     vector.internalArray = nullptr;
+    vector.aggregateCache = nullptr;
 }
 
 // конструктор со списком инициализации
@@ -175,15 +761,40 @@ template<typename T> MyVector<T>::~MyVector()
 
     delete[] internalArray;
     internalArray = nullptr;
+
+    delete aggregateCache;
+    aggregateCache = nullptr;
 }
 
 // перегрузка оператора присваивания
 template<typename T> MyVector<T> &MyVector<T>::operator=(const MyVector<T> &srcVector)
 {
+    if (this == &srcVector)
+        return *this;
+
+    delete[] internalArray;
+
     internalArray = new T[srcVector.internalArrayLength]{};
     internalArrayLength = srcVector.internalArrayLength;
     for(int i = 0; i < srcVector.internalArrayLength; i++)
-        internalArray[i] = srcVector.m_vec[i];
+        internalArray[i] = srcVector.internalArray[i];
+
+    resetAggregateCache();
+
+    return *this;
+}
+
+// присваивание перемещением
+template<typename T> MyVector<T> &MyVector<T>::operator=(MyVector<T> &&srcVector)
+{
+    if (this == &srcVector)
+        return *this;
+
+    std::swap(internalArray, srcVector.internalArray);
+    std::swap(internalArrayLength, srcVector.internalArrayLength);
+
+    resetAggregateCache();
+    srcVector.resetAggregateCache();
 
     return *this;
 }
@@ -198,11 +809,19 @@ template<typename T> int MyVector<T>::get_length() const
 template<typename T> void MyVector<T>::set_elem(int index, const T &element)
 {
     checkBounds(index);
+    markDirty(index);
     internalArray[index] = element;
 }
 
 // получить элемент списка по индексу
 template<typename T> T &MyVector<T>::get_elem(int index)
+{
+    checkBounds(index);
+    markDirty(index);
+    return internalArray[index];
+}
+
+template<typename T> const T &MyVector<T>::get_elem(int index) const
 {
     checkBounds(index);
     return internalArray[index];
@@ -219,8 +838,65 @@ template<typename T> T *MyVector<T>::to_array()
     return array;
 }
 
+// получить указатель на внутренний массив элементов (без копирования)
+template<typename T> T *MyVector<T>::data()
+{
+    // запись через указатель отследить нельзя, поэтому кэш агрегатов сбрасывается целиком
+    markAllDirty();
+    return internalArray;
+}
+
+template<typename T> const T *MyVector<T>::data() const
+{
+    return internalArray;
+}
+
+// собрать элементы по списку индексов: out[i] = this[indices[i]]
+template<typename T> void MyVector<T>::gather(const MyVector<int> &indices, MyVector<T> &out) const
+{
+    if (out.internalArrayLength != indices.get_length())
+        throw VectorException("Vector lengths must be equal");
+
+    if (&out == this)
+        throw VectorException("Output vector must differ from source vector");
+
+    checkIndices(indices);
+    out.markAllDirty();
+    gatherKernel(internalArray, indices.data(), out.internalArray, indices.get_length());
+}
+
+// записать элементы по списку индексов: this[indices[i]] = values[i]
+template<typename T> void MyVector<T>::scatter(const MyVector<int> &indices, const MyVector<T> &values)
+{
+    if (values.internalArrayLength != indices.get_length())
+        throw VectorException("Vector lengths must be equal");
+
+    checkIndices(indices);
+
+    // при повторяющихся индексах остаётся последнее записанное значение
+    const int *index = indices.data();
+    const T *source = values.internalArray;
+    int count = indices.get_length();
+    for(int i = 0; i < count; i++) {
+        if (i + PREFETCH_DISTANCE < count)
+            MYVECTOR_PREFETCH_WRITE(internalArray + index[i + PREFETCH_DISTANCE]);
+        internalArray[index[i]] = source[i];
+    }
+
+    if (aggregateCache != nullptr)
+        for(int i = 0; i < count; i++)
+            markDirty(index[i]);
+}
+
 // доступ к элементу, аналогично массиву
 template<typename T> T &MyVector<T>::operator [](int index)
+{
+    checkBounds(index);
+    markDirty(index);
+    return *(internalArray + index);
+}
+
+template<typename T> const T &MyVector<T>::operator [](int index) const
 {
     checkBounds(index);
     return *(internalArray + index);
@@ -262,7 +938,9 @@ template<typename T> MyVector<T> &MyVector<T>::operator += (const MyVector<T> &v
     for(int i = 0; i < vector.internalArrayLength; i++)
         internalArray[me.internalArrayLength + i] = vector.internalArray[i];
 
-    return me;
+    resetAggregateCache();
+
+    return *this;
 }
 
 // перегрузка оператора -=, из this вычитается vect
@@ -279,7 +957,9 @@ template<typename T> MyVector<T> &MyVector<T>::operator -= (const MyVector<T> &v
     for(int i = 0; i < internalArrayLength; i++)
         internalArray[i] = ((i < me.internalArrayLength) ? me.internalArray[i] : 0) -
                            ((i < vector.internalArrayLength) ? vector.internalArray[i] : 0);
-    return me;
+
+    resetAggregateCache();
+    return *this;
 }
 
 // перегрузка оператора *=, каждый элемент this домножается на val
@@ -287,6 +967,8 @@ template<typename T> MyVector<T> &MyVector<T>::operator *= (const T &value)
 {
     for(int i = 0; i < internalArrayLength; i++)
         internalArray[i] *= value;
+
+    markAllDirty();
     return *this;
 }
 
@@ -299,9 +981,219 @@ template<typename T> MyVector<T> &MyVector<T>::operator /= (const T &value)
     for(int i = 0; i < internalArrayLength; i++)
         internalArray[i] /= value;
 
+    markAllDirty();
+    return *this;
+}
+
+// this = a * x + this, каждый элемент читается и записывается один раз
+template<typename T> MyVector<T> &MyVector<T>::axpy(const T &a, const MyVector<T> &x)
+{
+    checkLength(x);
+
+    const T *source = x.internalArray;
+    for(int i = 0; i < internalArrayLength; i++)
+        internalArray[i] = fusedMultiplyAdd(a, source[i], internalArray[i]);
+
+    markAllDirty();
+    return *this;
+}
+
+// this = a * x + b * this
+template<typename T> MyVector<T> &MyVector<T>::axpby(const T &a, const MyVector<T> &x, const T &b)
+{
+    checkLength(x);
+
+    const T *source = x.internalArray;
+    for(int i = 0; i < internalArrayLength; i++)
+        internalArray[i] = fusedMultiplyAdd(a, source[i], b * internalArray[i]);
+
+    markAllDirty();
+    return *this;
+}
+
+// поэлементное умножение: this[i] *= x[i]
+template<typename T> MyVector<T> &MyVector<T>::hadamard(const MyVector<T> &x)
+{
+    checkLength(x);
+
+    const T *source = x.internalArray;
+    for(int i = 0; i < internalArrayLength; i++)
+        internalArray[i] *= source[i];
+
+    markAllDirty();
     return *this;
 }
 
+// поэлементное деление: this[i] /= x[i]
+template<typename T> MyVector<T> &MyVector<T>::hadamard_divide(const MyVector<T> &x)
+{
+    checkLength(x);
+
+    const T *source = x.internalArray;
+
+    // целочисленное деление на ноль не определено, поэтому делители проверяются заранее;
+    // для вещественных чисел результатом будет бесконечность или NaN
+    if constexpr (std::is_integral<T>::value) {
+        bool hasZero = false;
+        for(int i = 0; i < internalArrayLength; i++)
+            hasZero |= (source[i] == 0);
+        if (hasZero)
+            throw VectorException("division by zero");
+    }
+
+    for(int i = 0; i < internalArrayLength; i++)
+        internalArray[i] /= source[i];
+
+    markAllDirty();
+    return *this;
+}
+
+// this = a * b + c поэлементно
+template<typename T> MyVector<T> &MyVector<T>::fma(const MyVector<T> &a, const MyVector<T> &b, const MyVector<T> &c)
+{
+    checkLength(a);
+    checkLength(b);
+    checkLength(c);
+
+    const T *aData = a.internalArray;
+    const T *bData = b.internalArray;
+    const T *cData = c.internalArray;
+    for(int i = 0; i < internalArrayLength; i++)
+        internalArray[i] = fusedMultiplyAdd(aData[i], bData[i], cData[i]);
+
+    markAllDirty();
+    return *this;
+}
+
+// ограничить каждый элемент отрезком [low, high]
+template<typename T> MyVector<T> &MyVector<T>::clamp(const T &low, const T &high)
+{
+    if (high < low)
+        throw VectorException("Lower bound must not exceed upper bound");
+
+    for(int i = 0; i < internalArrayLength; i++) {
+        T value = internalArray[i];
+        value = (value < low) ? low : value;
+        internalArray[i] = (high < value) ? high : value;
+    }
+
+    markAllDirty();
+    return *this;
+}
+
+// заменить каждый элемент его модулем
+template<typename T> MyVector<T> &MyVector<T>::abs()
+{
+    if constexpr (std::is_floating_point<T>::value) {
+        for(int i = 0; i < internalArrayLength; i++)
+            internalArray[i] = std::fabs(internalArray[i]);
+    } else if constexpr (std::is_signed<T>::value) {
+        // -min() - переполнение (UB), поэтому наименьшее значение обрабатывается отдельно
+        const T lowest = std::numeric_limits<T>::min();
+        const T highest = std::numeric_limits<T>::max();
+        for(int i = 0; i < internalArrayLength; i++) {
+            T value = internalArray[i];
+            internalArray[i] = (value < 0) ? ((value == lowest) ? highest : T(-value)) : value;
+        }
+    }
+
+    markAllDirty();
+    return *this;
+}
+
+// включить кэширование агрегатов
+template<typename T> void MyVector<T>::enable_aggregate_cache(int blockSize)
+{
+    if (blockSize <= 0)
+        throw VectorException("Block size must be greater than zero");
+
+    int blockShift = 0;
+    while ((1LL << blockShift) < blockSize)
+        blockShift++;
+
+    delete aggregateCache;
+    aggregateCache = new AggregateCache(blockShift, internalArrayLength);
+}
+
+// выключить кэширование агрегатов
+template<typename T> void MyVector<T>::disable_aggregate_cache()
+{
+    delete aggregateCache;
+    aggregateCache = nullptr;
+}
+
+// включено ли кэширование агрегатов
+template<typename T> bool MyVector<T>::is_aggregate_cache_enabled() const
+{
+    return aggregateCache != nullptr;
+}
+
+// сумма элементов
+template<typename T> T MyVector<T>::sum() const
+{
+    if (aggregateCache != nullptr && internalArrayLength > 0) {
+        std::lock_guard<std::mutex> guard(aggregateCache->lock);
+        refreshAggregates();
+        return aggregateCache->sums[1];
+    }
+
+    T result = T();
+    for(int i = 0; i < internalArrayLength; i++)
+        result += internalArray[i];
+    return result;
+}
+
+// евклидова норма вектора
+template<typename T> double MyVector<T>::norm() const
+{
+    if (aggregateCache != nullptr && internalArrayLength > 0) {
+        std::lock_guard<std::mutex> guard(aggregateCache->lock);
+        refreshAggregates();
+        return std::sqrt(aggregateCache->squares[1]);
+    }
+
+    double squares = 0;
+    for(int i = 0; i < internalArrayLength; i++)
+        squares += (double)internalArray[i] * (double)internalArray[i];
+    return std::sqrt(squares);
+}
+
+// минимальный элемент
+template<typename T> T MyVector<T>::min_elem() const
+{
+    if (internalArrayLength == 0)
+        throw VectorException("Vector is empty");
+
+    if (aggregateCache != nullptr) {
+        std::lock_guard<std::mutex> guard(aggregateCache->lock);
+        refreshAggregates();
+        return aggregateCache->minimums[1];
+    }
+
+    T result = internalArray[0];
+    for(int i = 1; i < internalArrayLength; i++)
+        result = (internalArray[i] < result) ? internalArray[i] : result;
+    return result;
+}
+
+// максимальный элемент
+template<typename T> T MyVector<T>::max_elem() const
+{
+    if (internalArrayLength == 0)
+        throw VectorException("Vector is empty");
+
+    if (aggregateCache != nullptr) {
+        std::lock_guard<std::mutex> guard(aggregateCache->lock);
+        refreshAggregates();
+        return aggregateCache->maximums[1];
+    }
+
+    T result = internalArray[0];
+    for(int i = 1; i < internalArrayLength; i++)
+        result = (result < internalArray[i]) ? internalArray[i] : result;
+    return result;
+}
+
 // перегрузка оператора + к v1 добавлется v2
 template<typename _T> MyVector<_T> operator + (const MyVector<_T> &v1, const MyVector<_T> &v2)
 {
@@ -333,6 +1225,7 @@ template<typename _T, typename __T> MyVector<_T> operator * (const MyVector<_T>
 {
     for(int i = 0; i < v1.internalArrayLength; i++)
         v1.internalArray[i] *= value;
+    v1.markAllDirty();
 
     return v1;
 }
@@ -345,10 +1238,57 @@ template<typename _T, typename __T> MyVector<_T> operator / (const MyVector<_T>
 
     for(int i = 0; i < v1.internalArrayLength; i++)
         v1.internalArray[i] /= value;
+    v1.markAllDirty();
 
     return v1;
 }
 
+// поэлементное сравнение на равенство
+template<typename _T> bool operator ==(const MyVector<_T> &v1, const MyVector<_T> &v2)
+{
+    return v1.internalArrayLength == v2.internalArrayLength &&
+           MyVector<_T>::mismatch(v1.internalArray, v2.internalArray, v1.internalArrayLength) == v1.internalArrayLength;
+}
+
+template<typename _T> bool operator !=(const MyVector<_T> &v1, const MyVector<_T> &v2)
+{
+    return !(v1 == v2);
+}
+
+// лексикографическое сравнение
+template<typename _T> bool operator <(const MyVector<_T> &v1, const MyVector<_T> &v2)
+{
+    int common = std::min(v1.internalArrayLength, v2.internalArrayLength);
+    int index = MyVector<_T>::mismatch(v1.internalArray, v2.internalArray, common);
+    if (index == common)
+        return v1.internalArrayLength < v2.internalArrayLength;
+
+    return v1.internalArray[index] < v2.internalArray[index];
+}
+
+template<typename _T> bool operator <=(const MyVector<_T> &v1, const MyVector<_T> &v2)
+{
+    return !(v2 < v1);
+}
+
+template<typename _T> bool operator >(const MyVector<_T> &v1, const MyVector<_T> &v2)
+{
+    return v2 < v1;
+}
+
+template<typename _T> bool operator >=(const MyVector<_T> &v1, const MyVector<_T> &v2)
+{
+    return !(v1 < v2);
+}
+
+// хеш содержимого (XXH64 с начальным значением seed)
+template<typename T> unsigned long long MyVector<T>::hash(unsigned long long seed) const
+{
+    MyVectorHasher hasher(seed);
+    hasher.update(*this);
+    return hasher.digest();
+}
+
 // метод получения итератора на начало вектора (первый элемент)
 template<typename T> typename MyVector<T>::Iterator MyVector<T>::iterator_begin()
 {
@@ -385,7 +1325,7 @@ template <typename T> typename MyVector<T>::Iterator MyVector<T>::Iterator::next
 // получить значение текущего объекта в контейнере
 template <typename T> T MyVector<T>::Iterator::value()
 {
-    return vector[currentIndex];
+    return static_cast<const MyVector<T> &>(vector)[currentIndex];
 }
 
 // указывает ли итератор на конечный фиктивный элемент контейнера, следующий за последним
@@ -421,7 +1361,8 @@ template <typename T> bool MyVector<T>::Iterator::operator == (Iterator &b)
     if (is_end() && b.is_end() && is_end() == true)
         return true;
 
-    return vector[currentIndex] == b.vector[b.currentIndex];
+    return static_cast<const MyVector<T> &>(vector)[currentIndex] ==
+           static_cast<const MyVector<T> &>(b.vector)[b.currentIndex];
 }
 
 // оператор сравнения на неравенство
@@ -436,8 +1377,45 @@ template <typename T> bool MyVector<T>::Iterator::operator != (Iterator &b)
     if (is_end() && b.is_end() && is_end() == true)
         return false;
 
-    return vector[currentIndex] != b.vector[b.currentIndex];
+    return static_cast<const MyVector<T> &>(vector)[currentIndex] !=
+           static_cast<const MyVector<T> &>(b.vector)[b.currentIndex];
+}
+
+// хеш для std::unordered_map и std::unordered_set с ключами MyVector
+namespace std {
+template<typename T> struct hash<MyVector<T>> {
+    size_t operator ()(const MyVector<T> &vector) const
+    {
+        return (size_t)vector.hash();
+    }
+};
 }
 
+// Явные инстанцирования для распространённых типов элементов. Определения находятся в
+// MyVector.cpp (библиотека myvector); при сборке с ней задаётся MYVECTOR_EXTERN_TEMPLATES,
+// и эти специализации не компилируются заново в каждой единице трансляции.
+#define MYVECTOR_INSTANTIATE(EXTERN, T) \
+    EXTERN template class MyVector<T>; \
+    EXTERN template std::ostream &operator << <T>(std::ostream &os, const MyVector<T> &list); \
+    EXTERN template MyVector<T> operator + <T>(const MyVector<T> &v1, const MyVector<T> &v2); \
+    EXTERN template MyVector<T> operator - <T>(const MyVector<T> &v1, const MyVector<T> &v2); \
+    EXTERN template MyVector<T> operator * <T, T>(const MyVector<T> &v1, const T &value); \
+    EXTERN template MyVector<T> operator / <T, T>(const MyVector<T> &v1, const T &value); \
+    EXTERN template bool operator == <T>(const MyVector<T> &v1, const MyVector<T> &v2); \
+    EXTERN template bool operator != <T>(const MyVector<T> &v1, const MyVector<T> &v2); \
+    EXTERN template bool operator < <T>(const MyVector<T> &v1, const MyVector<T> &v2); \
+    EXTERN template bool operator <= <T>(const MyVector<T> &v1, const MyVector<T> &v2); \
+    EXTERN template bool operator > <T>(const MyVector<T> &v1, const MyVector<T> &v2); \
+    EXTERN template bool operator >= <T>(const MyVector<T> &v1, const MyVector<T> &v2);
+
+#define MYVECTOR_INSTANTIATE_COMMON_TYPES(EXTERN) \
+    MYVECTOR_INSTANTIATE(EXTERN, int) \
+    MYVECTOR_INSTANTIATE(EXTERN, long) \
+    MYVECTOR_INSTANTIATE(EXTERN, float) \
+    MYVECTOR_INSTANTIATE(EXTERN, double)
+
+#ifdef MYVECTOR_EXTERN_TEMPLATES
+MYVECTOR_INSTANTIATE_COMMON_TYPES(extern)
+#endif
 
 #endif // MyVector_H
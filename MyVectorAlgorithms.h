@@ -0,0 +1,633 @@
+#ifndef MyVectorAlgorithms_H
+#define MyVectorAlgorithms_H
+
+#include <algorithm>
+#include <cstring>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include "MyVector.h"
+#include "VectorException.h"
+
+// Алгоритмы над MyVector: сортировка, префиксные суммы, стабильное разбиение, удаление
+// повторов и двоичный поиск. У каждого алгоритма есть последовательная (_serial) и
+// многопоточная (_parallel) реализация, а функция без суффикса выбирает одну из них по
+// порогу из AlgorithmSettings.
+namespace MyVectorAlgorithms {
+
+// параметры многопоточного выполнения
+struct AlgorithmSettings {
+    // количество потоков (по умолчанию - число аппаратных потоков)
+    int threadCount;
+
+    // минимальная длина вектора, начиная с которой используется многопоточная версия
+    int parallelThreshold;
+
+    AlgorithmSettings(int threadCount = 0, int parallelThreshold = 1 << 16) :
+        threadCount(threadCount > 0 ? threadCount : std::max(1, (int)std::thread::hardware_concurrency())),
+        parallelThreshold(parallelThreshold)
+    {
+    }
+
+    // нужно ли выполнять алгоритм многопоточно для вектора длины length
+    bool use_parallel(int length) const
+    {
+        return threadCount > 1 && length >= parallelThreshold;
+    }
+};
+
+namespace detail {
+
+// разбивает [0, length) на threadCount непрерывных частей и вызывает body(part, begin, end)
+// для каждой в отдельном потоке; часть 0 выполняется в вызывающем потоке
+template<typename Body> void runParallel(int threadCount, int length, Body body)
+{
+    threadCount = std::max(1, std::min(threadCount, length));
+
+    std::vector<std::thread> threads;
+    threads.reserve(threadCount - 1);
+    for(int t = 1; t < threadCount; t++) {
+        int begin = (int)((long long)length * t / threadCount);
+        int end = (int)((long long)length * (t + 1) / threadCount);
+        threads.emplace_back(body, t, begin, end);
+    }
+
+    body(0, 0, (int)((long long)length / threadCount));
+
+    for(std::thread &thread : threads)
+        thread.join();
+}
+
+// может ли тип сортироваться поразрядной сортировкой
+template<typename T> struct IsRadixSortable {
+    static const bool value = (std::is_integral<T>::value && !std::is_same<T, bool>::value) ||
+                              std::is_same<T, float>::value || std::is_same<T, double>::value;
+};
+
+// беззнаковый тип ключа того же размера, что и T
+template<typename T> struct RadixKey {
+    typedef typename std::conditional<sizeof(T) == 1, unsigned char,
+            typename std::conditional<sizeof(T) == 2, unsigned short,
+            typename std::conditional<sizeof(T) == 4, unsigned int,
+                                      unsigned long long>::type>::type>::type type;
+};
+
+// преобразует элемент в беззнаковый ключ, порядок которого совпадает с порядком элементов
+template<typename T> typename RadixKey<T>::type radixKey(const T &value)
+{
+    typedef typename RadixKey<T>::type Key;
+    const Key signBit = (Key)((Key)1 << (sizeof(Key) * 8 - 1));
+
+    Key key;
+    std::memcpy(&key, &value, sizeof(Key));
+
+    if (std::is_floating_point<T>::value)
+        return (key & signBit) ? (Key)~key : (Key)(key | signBit);
+
+    if (std::is_signed<T>::value)
+        return (Key)(key ^ signBit);
+
+    return key;
+}
+
+// слияние отсортированных диапазонов [left, middle) и [middle, right) из source в target
+template<typename T> void mergeRanges(const T *source, T *target, int left, int middle, int right)
+{
+    int i = left, j = middle, k = left;
+
+    while (i < middle && j < right) {
+        if (source[j] < source[i])
+            target[k++] = source[j++];
+        else
+            target[k++] = source[i++];
+    }
+
+    while (i < middle)
+        target[k++] = source[i++];
+
+    while (j < right)
+        target[k++] = source[j++];
+}
+
+// восходящая сортировка слиянием диапазона [begin, end), результат остаётся в data
+template<typename T> void mergeSortRange(T *data, T *buffer, int begin, int end)
+{
+    const int INSERTION_RUN = 32;
+
+    // короткие серии сортируются вставками
+    for(int runBegin = begin; runBegin < end; runBegin += INSERTION_RUN) {
+        int runEnd = std::min(runBegin + INSERTION_RUN, end);
+        for(int i = runBegin + 1; i < runEnd; i++) {
+            T value = data[i];
+            int j = i - 1;
+            while (j >= runBegin && value < data[j]) {
+                data[j + 1] = data[j];
+                j--;
+            }
+            data[j + 1] = value;
+        }
+    }
+
+    T *source = data;
+    T *target = buffer;
+    for(int width = INSERTION_RUN; width < end - begin; width *= 2) {
+        for(int left = begin; left < end; left += 2 * width) {
+            int middle = std::min(left + width, end);
+            int right = std::min(left + 2 * width, end);
+            mergeRanges(source, target, left, middle, right);
+        }
+        std::swap(source, target);
+    }
+
+    if (source != data)
+        for(int i = begin; i < end; i++)
+            data[i] = source[i];
+}
+
+// последовательная поразрядная сортировка (LSD, по 8 бит за проход)
+template<typename T> void radixSortSerial(T *data, T *buffer, int length)
+{
+    typedef typename RadixKey<T>::type Key;
+
+    T *source = data;
+    T *target = buffer;
+    for(int pass = 0; pass < (int)sizeof(Key); pass++) {
+        const int shift = pass * 8;
+        int counts[256] = {};
+        for(int i = 0; i < length; i++)
+            counts[(radixKey(source[i]) >> shift) & 0xff]++;
+
+        // все элементы попали в один разряд - проход ничего не меняет
+        if (counts[(radixKey(source[0]) >> shift) & 0xff] == length)
+            continue;
+
+        int offset = 0;
+        for(int digit = 0; digit < 256; digit++) {
+            int count = counts[digit];
+            counts[digit] = offset;
+            offset += count;
+        }
+
+        for(int i = 0; i < length; i++)
+            target[counts[(radixKey(source[i]) >> shift) & 0xff]++] = source[i];
+
+        std::swap(source, target);
+    }
+
+    if (source != data)
+        for(int i = 0; i < length; i++)
+            data[i] = source[i];
+}
+
+// многопоточная поразрядная сортировка: локальные гистограммы потоков и общая раскладка
+template<typename T> void radixSortParallel(T *data, T *buffer, int length, int threadCount)
+{
+    typedef typename RadixKey<T>::type Key;
+
+    threadCount = std::max(1, std::min(threadCount, length));
+    std::vector<int> counts(threadCount * 256);
+
+    T *source = data;
+    T *target = buffer;
+    for(int pass = 0; pass < (int)sizeof(Key); pass++) {
+        const int shift = pass * 8;
+        std::fill(counts.begin(), counts.end(), 0);
+
+        runParallel(threadCount, length, [&](int part, int begin, int end) {
+            int *local = counts.data() + part * 256;
+            for(int i = begin; i < end; i++)
+                local[(radixKey(source[i]) >> shift) & 0xff]++;
+        });
+
+        int firstDigit = (radixKey(source[0]) >> shift) & 0xff;
+        int firstDigitCount = 0;
+        for(int part = 0; part < threadCount; part++)
+            firstDigitCount += counts[part * 256 + firstDigit];
+        if (firstDigitCount == length)
+            continue;
+
+        // смещения упорядочены по разряду, а внутри разряда - по номеру потока,
+        // поэтому сортировка остаётся устойчивой
+        int offset = 0;
+        for(int digit = 0; digit < 256; digit++)
+            for(int part = 0; part < threadCount; part++) {
+                int count = counts[part * 256 + digit];
+                counts[part * 256 + digit] = offset;
+                offset += count;
+            }
+
+        runParallel(threadCount, length, [&](int part, int begin, int end) {
+            int *local = counts.data() + part * 256;
+            for(int i = begin; i < end; i++)
+                target[local[(radixKey(source[i]) >> shift) & 0xff]++] = source[i];
+        });
+
+        std::swap(source, target);
+    }
+
+    if (source != data)
+        runParallel(threadCount, length, [&](int, int begin, int end) {
+            for(int i = begin; i < end; i++)
+                data[i] = source[i];
+        });
+}
+
+} // namespace detail
+
+// последовательная сортировка по возрастанию: поразрядная для целых и вещественных
+// чисел, устойчивая сортировка слиянием для остальных типов
+template<typename T> void sort_serial(MyVector<T> &vector)
+{
+    int length = vector.get_length();
+    if (length < 2)
+        return;
+
+    MyVector<T> buffer(length);
+    if constexpr (detail::IsRadixSortable<T>::value)
+        detail::radixSortSerial(vector.data(), buffer.data(), length);
+    else
+        detail::mergeSortRange(vector.data(), buffer.data(), 0, length);
+}
+
+// многопоточная сортировка по возрастанию
+template<typename T> void sort_parallel(MyVector<T> &vector, const AlgorithmSettings &settings = AlgorithmSettings())
+{
+    int length = vector.get_length();
+    if (length < 2)
+        return;
+
+    MyVector<T> buffer(length);
+    T *data = vector.data();
+    T *temp = buffer.data();
+
+    if constexpr (detail::IsRadixSortable<T>::value) {
+        detail::radixSortParallel(data, temp, length, settings.threadCount);
+    } else {
+        int parts = std::max(1, std::min(settings.threadCount, length));
+        std::vector<int> bounds(parts + 1);
+        for(int part = 0; part <= parts; part++)
+            bounds[part] = (int)((long long)length * part / parts);
+
+        // каждая часть сортируется в своём потоке
+        detail::runParallel(parts, length, [&](int, int begin, int end) {
+            detail::mergeSortRange(data, temp, begin, end);
+        });
+
+        // затем части попарно сливаются, пары на одном уровне - параллельно
+        T *source = data;
+        T *target = temp;
+        for(int width = 1; width < parts; width *= 2) {
+            int pairs = (parts + 2 * width - 1) / (2 * width);
+            detail::runParallel(pairs, pairs, [&](int, int firstPair, int lastPair) {
+                for(int pair = firstPair; pair < lastPair; pair++) {
+                    int left = bounds[pair * 2 * width];
+                    int middle = bounds[std::min(pair * 2 * width + width, parts)];
+                    int right = bounds[std::min(pair * 2 * width + 2 * width, parts)];
+                    detail::mergeRanges(source, target, left, middle, right);
+                }
+            });
+            std::swap(source, target);
+        }
+
+        if (source != data)
+            for(int i = 0; i < length; i++)
+                data[i] = source[i];
+    }
+}
+
+// сортировка по возрастанию, многопоточная для длинных векторов
+template<typename T> void sort(MyVector<T> &vector, const AlgorithmSettings &settings = AlgorithmSettings())
+{
+    if (settings.use_parallel(vector.get_length()))
+        sort_parallel(vector, settings);
+    else
+        sort_serial(vector);
+}
+
+// последовательная включающая префиксная сумма: v[i] = v[0] + ... + v[i]
+template<typename T> void inclusive_scan_serial(MyVector<T> &vector)
+{
+    T *data = vector.data();
+    for(int i = 1; i < vector.get_length(); i++)
+        data[i] = data[i - 1] + data[i];
+}
+
+// многопоточная включающая префиксная сумма (два прохода по частям вектора)
+template<typename T> void inclusive_scan_parallel(MyVector<T> &vector, const AlgorithmSettings &settings = AlgorithmSettings())
+{
+    int length = vector.get_length();
+    if (length == 0)
+        return;
+
+    T *data = vector.data();
+    int parts = std::max(1, std::min(settings.threadCount, length));
+    std::vector<T> partSums(parts);
+
+    // первый проход: локальные суммы частей
+    detail::runParallel(parts, length, [&](int part, int begin, int end) {
+        for(int i = begin + 1; i < end; i++)
+            data[i] = data[i - 1] + data[i];
+        partSums[part] = data[end - 1];
+    });
+
+    // второй проход: к каждой части прибавляется сумма всех предыдущих
+    for(int part = 1; part < parts; part++)
+        partSums[part] = partSums[part - 1] + partSums[part];
+
+    detail::runParallel(parts, length, [&](int part, int begin, int end) {
+        if (part == 0)
+            return;
+        T offset = partSums[part - 1];
+        for(int i = begin; i < end; i++)
+            data[i] = offset + data[i];
+    });
+}
+
+// включающая префиксная сумма, многопоточная для длинных векторов
+template<typename T> void inclusive_scan(MyVector<T> &vector, const AlgorithmSettings &settings = AlgorithmSettings())
+{
+    if (settings.use_parallel(vector.get_length()))
+        inclusive_scan_parallel(vector, settings);
+    else
+        inclusive_scan_serial(vector);
+}
+
+// последовательная исключающая префиксная сумма: v[i] = init + v[0] + ... + v[i - 1]
+template<typename T> void exclusive_scan_serial(MyVector<T> &vector, const T &init = T())
+{
+    T *data = vector.data();
+    T running = init;
+    for(int i = 0; i < vector.get_length(); i++) {
+        T value = data[i];
+        data[i] = running;
+        running = running + value;
+    }
+}
+
+// многопоточная исключающая префиксная сумма
+template<typename T> void exclusive_scan_parallel(MyVector<T> &vector, const T &init = T(),
+                                                  const AlgorithmSettings &settings = AlgorithmSettings())
+{
+    int length = vector.get_length();
+    if (length == 0)
+        return;
+
+    T *data = vector.data();
+    int parts = std::max(1, std::min(settings.threadCount, length));
+    std::vector<T> partSums(parts);
+
+    detail::runParallel(parts, length, [&](int part, int begin, int end) {
+        T sum = data[begin];
+        for(int i = begin + 1; i < end; i++)
+            sum = sum + data[i];
+        partSums[part] = sum;
+    });
+
+    // смещение каждой части - init плюс суммы всех предыдущих частей
+    T running = init;
+    for(int part = 0; part < parts; part++) {
+        T sum = partSums[part];
+        partSums[part] = running;
+        running = running + sum;
+    }
+
+    detail::runParallel(parts, length, [&](int part, int begin, int end) {
+        T running = partSums[part];
+        for(int i = begin; i < end; i++) {
+            T value = data[i];
+            data[i] = running;
+            running = running + value;
+        }
+    });
+}
+
+// исключающая префиксная сумма, многопоточная для длинных векторов
+template<typename T> void exclusive_scan(MyVector<T> &vector, const T &init = T(),
+                                         const AlgorithmSettings &settings = AlgorithmSettings())
+{
+    if (settings.use_parallel(vector.get_length()))
+        exclusive_scan_parallel(vector, init, settings);
+    else
+        exclusive_scan_serial(vector, init);
+}
+
+// последовательное стабильное разбиение: элементы, удовлетворяющие predicate, перемещаются
+// в начало с сохранением порядка; возвращает количество таких элементов
+template<typename T, typename Predicate> int stable_partition_serial(MyVector<T> &vector, Predicate predicate)
+{
+    int length = vector.get_length();
+    T *data = vector.data();
+    MyVector<T> rejected(length);
+    T *rejectedData = rejected.data();
+
+    int accepted = 0, rejectedCount = 0;
+    for(int i = 0; i < length; i++) {
+        if (predicate(data[i]))
+            data[accepted++] = data[i];
+        else
+            rejectedData[rejectedCount++] = data[i];
+    }
+
+    for(int i = 0; i < rejectedCount; i++)
+        data[accepted + i] = rejectedData[i];
+
+    return accepted;
+}
+
+// многопоточное стабильное разбиение
+template<typename T, typename Predicate> int stable_partition_parallel(MyVector<T> &vector, Predicate predicate,
+                                                                       const AlgorithmSettings &settings = AlgorithmSettings())
+{
+    int length = vector.get_length();
+    if (length == 0)
+        return 0;
+
+    T *data = vector.data();
+    int parts = std::max(1, std::min(settings.threadCount, length));
+    MyVector<unsigned char> flags(length);
+    unsigned char *flagData = flags.data();
+    std::vector<int> acceptedCounts(parts);
+
+    // предикат вычисляется ровно один раз для каждого элемента
+    detail::runParallel(parts, length, [&](int part, int begin, int end) {
+        int count = 0;
+        for(int i = begin; i < end; i++) {
+            flagData[i] = predicate(data[i]) ? 1 : 0;
+            count += flagData[i];
+        }
+        acceptedCounts[part] = count;
+    });
+
+    std::vector<int> acceptedOffsets(parts), rejectedOffsets(parts);
+    int totalAccepted = 0;
+    for(int part = 0; part < parts; part++) {
+        acceptedOffsets[part] = totalAccepted;
+        totalAccepted += acceptedCounts[part];
+    }
+    int rejectedOffset = totalAccepted;
+    for(int part = 0; part < parts; part++) {
+        int begin = (int)((long long)length * part / parts);
+        int end = (int)((long long)length * (part + 1) / parts);
+        rejectedOffsets[part] = rejectedOffset;
+        rejectedOffset += (end - begin) - acceptedCounts[part];
+    }
+
+    MyVector<T> result(length);
+    T *resultData = result.data();
+    detail::runParallel(parts, length, [&](int part, int begin, int end) {
+        int accepted = acceptedOffsets[part];
+        int rejected = rejectedOffsets[part];
+        for(int i = begin; i < end; i++) {
+            if (flagData[i])
+                resultData[accepted++] = data[i];
+            else
+                resultData[rejected++] = data[i];
+        }
+    });
+
+    detail::runParallel(parts, length, [&](int, int begin, int end) {
+        for(int i = begin; i < end; i++)
+            data[i] = resultData[i];
+    });
+
+    return totalAccepted;
+}
+
+// стабильное разбиение, многопоточное для длинных векторов
+template<typename T, typename Predicate> int stable_partition(MyVector<T> &vector, Predicate predicate,
+                                                              const AlgorithmSettings &settings = AlgorithmSettings())
+{
+    if (settings.use_parallel(vector.get_length()))
+        return stable_partition_parallel(vector, predicate, settings);
+
+    return stable_partition_serial(vector, predicate);
+}
+
+// последовательное удаление подряд идущих повторов; возвращает новый вектор
+template<typename T> MyVector<T> unique_serial(const MyVector<T> &vector)
+{
+    int length = vector.get_length();
+    const T *data = vector.data();
+
+    int count = 0;
+    for(int i = 0; i < length; i++)
+        if (i == 0 || !(data[i] == data[i - 1]))
+            count++;
+
+    MyVector<T> result(count);
+    T *resultData = result.data();
+    int k = 0;
+    for(int i = 0; i < length; i++)
+        if (i == 0 || !(data[i] == data[i - 1]))
+            resultData[k++] = data[i];
+
+    return result;
+}
+
+// многопоточное удаление подряд идущих повторов
+template<typename T> MyVector<T> unique_parallel(const MyVector<T> &vector,
+                                                 const AlgorithmSettings &settings = AlgorithmSettings())
+{
+    int length = vector.get_length();
+    if (length == 0)
+        return MyVector<T>(0);
+
+    const T *data = vector.data();
+    int parts = std::max(1, std::min(settings.threadCount, length));
+    std::vector<int> offsets(parts + 1);
+
+    detail::runParallel(parts, length, [&](int part, int begin, int end) {
+        int count = 0;
+        for(int i = begin; i < end; i++)
+            if (i == 0 || !(data[i] == data[i - 1]))
+                count++;
+        offsets[part + 1] = count;
+    });
+
+    for(int part = 0; part < parts; part++)
+        offsets[part + 1] += offsets[part];
+
+    MyVector<T> result(offsets[parts]);
+    T *resultData = result.data();
+    detail::runParallel(parts, length, [&](int part, int begin, int end) {
+        int k = offsets[part];
+        for(int i = begin; i < end; i++)
+            if (i == 0 || !(data[i] == data[i - 1]))
+                resultData[k++] = data[i];
+    });
+
+    return result;
+}
+
+// удаление подряд идущих повторов, многопоточное для длинных векторов
+template<typename T> MyVector<T> unique(const MyVector<T> &vector, const AlgorithmSettings &settings = AlgorithmSettings())
+{
+    if (settings.use_parallel(vector.get_length()))
+        return unique_parallel(vector, settings);
+
+    return unique_serial(vector);
+}
+
+// двоичный поиск в отсортированном векторе: индекс первого элемента, не меньшего value
+template<typename T> int lower_bound(const MyVector<T> &vector, const T &value)
+{
+    const T *data = vector.data();
+    int first = 0;
+    int count = vector.get_length();
+
+    while (count > 0) {
+        int step = count / 2;
+        if (data[first + step] < value) {
+            first += step + 1;
+            count -= step + 1;
+        } else {
+            count = step;
+        }
+    }
+
+    return first;
+}
+
+// последовательный пакетный двоичный поиск: result[i] = lower_bound(vector, values[i])
+template<typename T> MyVector<int> lower_bound_serial(const MyVector<T> &vector, const MyVector<T> &values)
+{
+    MyVector<int> result(values.get_length());
+    int *resultData = result.data();
+    const T *valueData = values.data();
+
+    for(int i = 0; i < values.get_length(); i++)
+        resultData[i] = lower_bound(vector, valueData[i]);
+
+    return result;
+}
+
+// многопоточный пакетный двоичный поиск
+template<typename T> MyVector<int> lower_bound_parallel(const MyVector<T> &vector, const MyVector<T> &values,
+                                                        const AlgorithmSettings &settings = AlgorithmSettings())
+{
+    MyVector<int> result(values.get_length());
+    int *resultData = result.data();
+    const T *valueData = values.data();
+
+    detail::runParallel(settings.threadCount, values.get_length(), [&](int, int begin, int end) {
+        for(int i = begin; i < end; i++)
+            resultData[i] = lower_bound(vector, valueData[i]);
+    });
+
+    return result;
+}
+
+// пакетный двоичный поиск, многопоточный для большого числа запросов
+template<typename T> MyVector<int> lower_bound(const MyVector<T> &vector, const MyVector<T> &values,
+                                               const AlgorithmSettings &settings = AlgorithmSettings())
+{
+    if (settings.use_parallel(values.get_length()))
+        return lower_bound_parallel(vector, values, settings);
+
+    return lower_bound_serial(vector, values);
+}
+
+} // namespace MyVectorAlgorithms
+
+#endif // MyVectorAlgorithms_H
@@ -0,0 +1,339 @@
+#ifndef MyVectorGenerators_H
+#define MyVectorGenerators_H
+
+#include <algorithm>
+#include <type_traits>
+#include <utility>
+
+#include "MyVector.h"
+#include "VectorException.h"
+
+// Ленивые векторы, элементы которых вычисляются по индексу прямо в цикле потребителя и
+// никогда не хранятся в памяти: константа, арифметическая прогрессия, равномерная сетка и
+// воспроизводимый псевдослучайный вектор. Генераторы участвуют в арифметике с MyVector по тем
+// же правилам, что и MyVector: + и += - конкатенация, - и -= дополняют более короткий операнд
+// нулями, axpy, axpby, hadamard и hadamard_divide требуют равных длин. Значения генератора
+// вычисляются прямо в цикле операции, без промежуточного MyVector.
+namespace MyVectorGenerators {
+
+// базовый класс генератора; Derived реализует T value(int index) const
+template <typename Derived, typename T> class MyVectorGenerator {
+protected:
+    int length;
+
+    // конструктор с указанием размерности
+    explicit MyVectorGenerator(int length) : length(length)
+    {
+        if (length < 0)
+            throw VectorException("Length of vector must be greater or equal zero");
+    }
+
+public:
+    typedef T value_type;
+
+    // получить размер
+    int get_length() const
+    {
+        return length;
+    }
+
+    // получить элемент по индексу без проверки границ
+    T value(int index) const
+    {
+        return static_cast<const Derived *>(this)->value(index);
+    }
+
+    // доступ к элементу с проверкой границ
+    T operator [](int index) const
+    {
+        if (index < 0)
+            throw VectorException("Index must be greater than zero");
+
+        if (length <= index)
+            throw VectorException("Index out of range");
+
+        return value(index);
+    }
+
+    // вычислить все элементы в обычный MyVector
+    MyVector<T> materialize() const
+    {
+        MyVector<T> result(length);
+        T *target = result.data();
+        for(int i = 0; i < length; i++)
+            target[i] = value(i);
+
+        return result;
+    }
+};
+
+// вектор, все элементы которого равны одному значению
+template <typename T> class ConstantGenerator : public MyVectorGenerator<ConstantGenerator<T>, T> {
+private:
+    T constantValue;
+public:
+    ConstantGenerator(int length, const T &value) :
+        MyVectorGenerator<ConstantGenerator<T>, T>(length), constantValue(value) {}
+
+    T value(int) const
+    {
+        return constantValue;
+    }
+};
+
+// арифметическая прогрессия start, start + step, start + 2 * step, ...
+template <typename T> class IotaGenerator : public MyVectorGenerator<IotaGenerator<T>, T> {
+private:
+    T start;
+    T step;
+public:
+    IotaGenerator(int length, const T &start, const T &step) :
+        MyVectorGenerator<IotaGenerator<T>, T>(length), start(start), step(step) {}
+
+    T value(int index) const
+    {
+        return start + step * (T)index;
+    }
+};
+
+// length равноотстоящих точек от first до last включительно
+template <typename T> class LinspaceGenerator : public MyVectorGenerator<LinspaceGenerator<T>, T> {
+private:
+    double first;
+    double step;
+    T last;
+public:
+    LinspaceGenerator(int length, const T &first, const T &last) :
+        MyVectorGenerator<LinspaceGenerator<T>, T>(length), first((double)first),
+        step(length > 1 ? ((double)last - (double)first) / (length - 1) : 0.0), last(last) {}
+
+    T value(int index) const
+    {
+        // последняя точка возвращается точно, без накопленной ошибки округления
+        return (index == this->length - 1 && index > 0) ? last : (T)(first + step * index);
+    }
+};
+
+// псевдослучайный вектор: элемент зависит только от seed и индекса (хеш splitmix64),
+// поэтому доступ произвольный и повторный проход даёт те же значения; вещественные
+// значения равномерны на [low, high), целые - на [low, high]
+template <typename T> class RandomGenerator : public MyVectorGenerator<RandomGenerator<T>, T> {
+private:
+    unsigned long long seed;
+    T low;
+    T high;
+
+    static unsigned long long mix(unsigned long long x)
+    {
+        x += 0x9e3779b97f4a7c15ULL;
+        x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+        return x ^ (x >> 31);
+    }
+public:
+    RandomGenerator(int length, unsigned long long seed, const T &low, const T &high) :
+        MyVectorGenerator<RandomGenerator<T>, T>(length), seed(seed), low(low), high(high)
+    {
+        if (high < low)
+            throw VectorException("Lower bound must not exceed upper bound");
+    }
+
+    T value(int index) const
+    {
+        unsigned long long bits = mix(seed ^ mix((unsigned long long)index));
+
+        if constexpr (std::is_floating_point<T>::value) {
+            double unit = (double)(bits >> 11) * (1.0 / 9007199254740992.0);
+            return (T)(low + (high - low) * unit);
+        } else {
+            unsigned long long range = (unsigned long long)high - (unsigned long long)low + 1;
+            return (T)((unsigned long long)low + (range == 0 ? bits : bits % range));
+        }
+    }
+};
+
+// вектор длины length, все элементы которого равны value
+template<typename T> ConstantGenerator<T> constant(int length, const T &value)
+{
+    return ConstantGenerator<T>(length, value);
+}
+
+// арифметическая прогрессия длины length
+template<typename T> IotaGenerator<T> iota(int length, const T &start, const T &step = T(1))
+{
+    return IotaGenerator<T>(length, start, step);
+}
+
+// length равноотстоящих точек от first до last включительно
+template<typename T> LinspaceGenerator<T> linspace(int length, const T &first, const T &last)
+{
+    return LinspaceGenerator<T>(length, first, last);
+}
+
+// воспроизводимый псевдослучайный вектор длины length
+template<typename T> RandomGenerator<T> random_vector(int length, unsigned long long seed, const T &low, const T &high)
+{
+    return RandomGenerator<T>(length, seed, low, high);
+}
+
+// перегрузка оператора -, из vector вычитается генератор
+template<typename Derived, typename T> MyVector<T> operator - (const MyVector<T> &vector,
+                                                               const MyVectorGenerator<Derived, T> &generator)
+{
+    MyVector<T> result(std::max(vector.get_length(), generator.get_length()));
+    T *target = result.data();
+    const T *source = vector.data();
+    int common = std::min(vector.get_length(), generator.get_length());
+
+    for(int i = 0; i < common; i++)
+        target[i] = source[i] - generator.value(i);
+    for(int i = common; i < vector.get_length(); i++)
+        target[i] = source[i];
+    for(int i = common; i < generator.get_length(); i++)
+        target[i] = T() - generator.value(i);
+
+    return result;
+}
+
+// перегрузка оператора -, из генератора вычитается vector
+template<typename Derived, typename T> MyVector<T> operator - (const MyVectorGenerator<Derived, T> &generator,
+                                                               const MyVector<T> &vector)
+{
+    MyVector<T> result(std::max(vector.get_length(), generator.get_length()));
+    T *target = result.data();
+    const T *source = vector.data();
+    int common = std::min(vector.get_length(), generator.get_length());
+
+    for(int i = 0; i < common; i++)
+        target[i] = generator.value(i) - source[i];
+    for(int i = common; i < generator.get_length(); i++)
+        target[i] = generator.value(i);
+    for(int i = common; i < vector.get_length(); i++)
+        target[i] = T() - source[i];
+
+    return result;
+}
+
+// перегрузка оператора -=, из vector вычитается генератор; без выделения памяти, если
+// генератор не длиннее вектора
+template<typename Derived, typename T> MyVector<T> &operator -= (MyVector<T> &vector,
+                                                                 const MyVectorGenerator<Derived, T> &generator)
+{
+    if (generator.get_length() > vector.get_length()) {
+        vector = vector - generator;
+        return vector;
+    }
+
+    T *target = vector.data();
+    for(int i = 0; i < generator.get_length(); i++)
+        target[i] -= generator.value(i);
+
+    return vector;
+}
+
+// перегрузка оператора +, к vector добавляются элементы генератора (конкатенация)
+template<typename Derived, typename T> MyVector<T> operator + (const MyVector<T> &vector,
+                                                               const MyVectorGenerator<Derived, T> &generator)
+{
+    MyVector<T> result(vector.get_length() + generator.get_length());
+    T *target = result.data();
+    std::copy(vector.data(), vector.data() + vector.get_length(), target);
+
+    target += vector.get_length();
+    for(int i = 0; i < generator.get_length(); i++)
+        target[i] = generator.value(i);
+
+    return result;
+}
+
+// перегрузка оператора +, к элементам генератора добавляется vector (конкатенация)
+template<typename Derived, typename T> MyVector<T> operator + (const MyVectorGenerator<Derived, T> &generator,
+                                                               const MyVector<T> &vector)
+{
+    MyVector<T> result(generator.get_length() + vector.get_length());
+    T *target = result.data();
+    for(int i = 0; i < generator.get_length(); i++)
+        target[i] = generator.value(i);
+
+    std::copy(vector.data(), vector.data() + vector.get_length(), target + generator.get_length());
+    return result;
+}
+
+// перегрузка оператора +=, к vector добавляются элементы генератора
+template<typename Derived, typename T> MyVector<T> &operator += (MyVector<T> &vector,
+                                                                 const MyVectorGenerator<Derived, T> &generator)
+{
+    vector = vector + generator;
+    return vector;
+}
+
+// проверяет, что длина генератора совпадает с длиной vector
+template<typename Derived, typename T> void checkLength(const MyVector<T> &vector,
+                                                        const MyVectorGenerator<Derived, T> &generator)
+{
+    if (vector.get_length() != generator.get_length())
+        throw VectorException("Vector lengths must be equal");
+}
+
+// vector = a * x + vector
+template<typename Derived, typename T> MyVector<T> &axpy(MyVector<T> &vector, const T &a,
+                                                         const MyVectorGenerator<Derived, T> &x)
+{
+    checkLength(vector, x);
+
+    T *target = vector.data();
+    for(int i = 0; i < vector.get_length(); i++)
+        target[i] += a * x.value(i);
+
+    return vector;
+}
+
+// vector = a * x + b * vector
+template<typename Derived, typename T> MyVector<T> &axpby(MyVector<T> &vector, const T &a,
+                                                          const MyVectorGenerator<Derived, T> &x, const T &b)
+{
+    checkLength(vector, x);
+
+    T *target = vector.data();
+    for(int i = 0; i < vector.get_length(); i++)
+        target[i] = a * x.value(i) + b * target[i];
+
+    return vector;
+}
+
+// поэлементное умножение: vector[i] *= x[i]
+template<typename Derived, typename T> MyVector<T> &hadamard(MyVector<T> &vector,
+                                                             const MyVectorGenerator<Derived, T> &x)
+{
+    checkLength(vector, x);
+
+    T *target = vector.data();
+    for(int i = 0; i < vector.get_length(); i++)
+        target[i] *= x.value(i);
+
+    return vector;
+}
+
+// поэлементное деление: vector[i] /= x[i]; целочисленный ноль среди делителей - исключение
+// до изменения vector, как и у MyVector::hadamard_divide
+template<typename Derived, typename T> MyVector<T> &hadamard_divide(MyVector<T> &vector,
+                                                                    const MyVectorGenerator<Derived, T> &x)
+{
+    checkLength(vector, x);
+
+    if constexpr (std::is_integral<T>::value) {
+        for(int i = 0; i < x.get_length(); i++)
+            if (x.value(i) == 0)
+                throw VectorException("division by zero");
+    }
+
+    T *target = vector.data();
+    for(int i = 0; i < vector.get_length(); i++)
+        target[i] /= x.value(i);
+
+    return vector;
+}
+
+} // namespace MyVectorGenerators
+
+#endif // MyVectorGenerators_H
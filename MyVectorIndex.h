@@ -0,0 +1,1276 @@
+#ifndef MyVectorIndex_H
+#define MyVectorIndex_H
+
+#include <algorithm>
+#include <atomic>
+#include <climits>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#if defined(__AVX2__) && defined(__FMA__)
+#include <immintrin.h>
+#endif
+
+#include "MyMatrix.h"
+#include "MyVector.h"
+#include "MyVectorAlgorithms.h"
+#include "VectorException.h"
+
+// Поиск ближайших соседей среди векторов одинаковой длины. FlatIndex хранит векторы одним
+// непрерывным массивом и находит точный ответ полным перебором с SIMD-ядрами расстояний и
+// кучей на k лучших. HnswIndex строит иерархический граф близости (HNSW) и находит
+// приближённый ответ, просматривая лишь небольшую часть векторов. Оба индекса умеют
+// обрабатывать запросы в нескольких потоках и сохраняться в двоичный файл.
+namespace MyVectorIndex {
+
+// мера близости; во всех случаях меньшее расстояние означает более близкий вектор
+enum Metric {
+    L2,             // квадрат евклидова расстояния
+    INNER_PRODUCT,  // скалярное произведение со знаком минус
+    COSINE          // 1 - косинус угла; векторы нормируются при добавлении
+};
+
+// найденный сосед: номер вектора в индексе и расстояние до запроса
+template <typename T> struct Neighbor {
+    int id;
+    T distance;
+};
+
+namespace detail {
+
+#if defined(__AVX2__) && defined(__FMA__)
+// сумма элементов регистра
+inline float horizontalSum(__m256 value)
+{
+    __m128 sum = _mm_add_ps(_mm256_castps256_ps128(value), _mm256_extractf128_ps(value, 1));
+    sum = _mm_hadd_ps(sum, sum);
+    sum = _mm_hadd_ps(sum, sum);
+    return _mm_cvtss_f32(sum);
+}
+
+inline double horizontalSum(__m256d value)
+{
+    __m128d sum = _mm_add_pd(_mm256_castpd256_pd128(value), _mm256_extractf128_pd(value, 1));
+    return _mm_cvtsd_f64(_mm_hadd_pd(sum, sum));
+}
+#endif
+
+// скалярное произведение a и b длины n
+template<typename T> T dot(const T *a, const T *b, int n)
+{
+    int i = 0;
+    T result = T();
+
+#if defined(__AVX2__) && defined(__FMA__)
+    if constexpr (std::is_same<T, float>::value) {
+        __m256 s0 = _mm256_setzero_ps(), s1 = _mm256_setzero_ps();
+        for(; i + 16 <= n; i += 16) {
+            s0 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i), s0);
+            s1 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i + 8), _mm256_loadu_ps(b + i + 8), s1);
+        }
+        result = horizontalSum(_mm256_add_ps(s0, s1));
+    } else if constexpr (std::is_same<T, double>::value) {
+        __m256d s0 = _mm256_setzero_pd(), s1 = _mm256_setzero_pd();
+        for(; i + 8 <= n; i += 8) {
+            s0 = _mm256_fmadd_pd(_mm256_loadu_pd(a + i), _mm256_loadu_pd(b + i), s0);
+            s1 = _mm256_fmadd_pd(_mm256_loadu_pd(a + i + 4), _mm256_loadu_pd(b + i + 4), s1);
+        }
+        result = horizontalSum(_mm256_add_pd(s0, s1));
+    }
+#endif
+
+    // четыре независимые суммы, чтобы компилятор мог векторизовать цикл
+    T s0 = T(), s1 = T(), s2 = T(), s3 = T();
+    for(; i + 4 <= n; i += 4) {
+        s0 += a[i] * b[i];
+        s1 += a[i + 1] * b[i + 1];
+        s2 += a[i + 2] * b[i + 2];
+        s3 += a[i + 3] * b[i + 3];
+    }
+    for(; i < n; i++)
+        s0 += a[i] * b[i];
+
+    return result + ((s0 + s1) + (s2 + s3));
+}
+
+// квадрат евклидова расстояния между a и b длины n
+template<typename T> T squaredL2(const T *a, const T *b, int n)
+{
+    int i = 0;
+    T result = T();
+
+#if defined(__AVX2__) && defined(__FMA__)
+    if constexpr (std::is_same<T, float>::value) {
+        __m256 s0 = _mm256_setzero_ps(), s1 = _mm256_setzero_ps();
+        for(; i + 16 <= n; i += 16) {
+            __m256 d0 = _mm256_sub_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i));
+            __m256 d1 = _mm256_sub_ps(_mm256_loadu_ps(a + i + 8), _mm256_loadu_ps(b + i + 8));
+            s0 = _mm256_fmadd_ps(d0, d0, s0);
+            s1 = _mm256_fmadd_ps(d1, d1, s1);
+        }
+        result = horizontalSum(_mm256_add_ps(s0, s1));
+    } else if constexpr (std::is_same<T, double>::value) {
+        __m256d s0 = _mm256_setzero_pd(), s1 = _mm256_setzero_pd();
+        for(; i + 8 <= n; i += 8) {
+            __m256d d0 = _mm256_sub_pd(_mm256_loadu_pd(a + i), _mm256_loadu_pd(b + i));
+            __m256d d1 = _mm256_sub_pd(_mm256_loadu_pd(a + i + 4), _mm256_loadu_pd(b + i + 4));
+            s0 = _mm256_fmadd_pd(d0, d0, s0);
+            s1 = _mm256_fmadd_pd(d1, d1, s1);
+        }
+        result = horizontalSum(_mm256_add_pd(s0, s1));
+    }
+#endif
+
+    T s0 = T(), s1 = T(), s2 = T(), s3 = T();
+    for(; i + 4 <= n; i += 4) {
+        T d0 = a[i] - b[i], d1 = a[i + 1] - b[i + 1], d2 = a[i + 2] - b[i + 2], d3 = a[i + 3] - b[i + 3];
+        s0 += d0 * d0;
+        s1 += d1 * d1;
+        s2 += d2 * d2;
+        s3 += d3 * d3;
+    }
+    for(; i < n; i++) {
+        T d = a[i] - b[i];
+        s0 += d * d;
+    }
+
+    return result + ((s0 + s1) + (s2 + s3));
+}
+
+// расстояние между a и b в заданной мере; для COSINE оба вектора уже нормированы
+template<typename T> T distance(Metric metric, const T *a, const T *b, int n)
+{
+    if (metric == L2)
+        return squaredL2(a, b, n);
+
+    T product = dot(a, b, n);
+    return metric == COSINE ? T(1) - product : -product;
+}
+
+// нормирует вектор на месте; нулевой вектор не изменяется
+template<typename T> void normalize(T *vector, int n)
+{
+    T norm = std::sqrt(dot(vector, vector, n));
+    if (norm > T())
+        for(int i = 0; i < n; i++)
+            vector[i] /= norm;
+}
+
+// k ближайших из просмотренных кандидатов; в вершине кучи - самый дальний
+template <typename T> class TopK {
+private:
+    int capacity;
+    std::vector<Neighbor<T>> heap;
+
+    // a ближе b, при равных расстояниях ближе меньший номер
+    static bool closer(const Neighbor<T> &a, const Neighbor<T> &b)
+    {
+        return a.distance < b.distance || (a.distance == b.distance && a.id < b.id);
+    }
+
+public:
+    explicit TopK(int capacity) : capacity(capacity)
+    {
+        heap.reserve(capacity);
+    }
+
+    int get_size() const
+    {
+        return (int)heap.size();
+    }
+
+    // попадёт ли в результат кандидат с расстоянием distance
+    bool accepts(const T &distance) const
+    {
+        return (int)heap.size() < capacity || distance <= heap.front().distance;
+    }
+
+    void push(int id, const T &distance)
+    {
+        Neighbor<T> candidate = {id, distance};
+        if ((int)heap.size() < capacity) {
+            heap.push_back(candidate);
+            std::push_heap(heap.begin(), heap.end(), closer);
+        } else if (closer(candidate, heap.front())) {
+            std::pop_heap(heap.begin(), heap.end(), closer);
+            heap.back() = candidate;
+            std::push_heap(heap.begin(), heap.end(), closer);
+        }
+    }
+
+    void merge(const TopK<T> &other)
+    {
+        for(const Neighbor<T> &neighbor : other.heap)
+            push(neighbor.id, neighbor.distance);
+    }
+
+    // записать найденных соседей в порядке возрастания расстояния
+    void extract(Neighbor<T> *out)
+    {
+        std::sort_heap(heap.begin(), heap.end(), closer);
+        std::copy(heap.begin(), heap.end(), out);
+    }
+};
+
+// метки посещённых узлов графа; очистка между поисками - увеличение номера метки
+struct VisitedSet {
+    std::vector<unsigned> marks;
+    unsigned tag = 0;
+
+    void reset(int size)
+    {
+        if ((int)marks.size() < size)
+            marks.resize(size, 0);
+        if (++tag == 0) {
+            std::fill(marks.begin(), marks.end(), 0);
+            tag = 1;
+        }
+    }
+
+    // отметить узел, false - если он уже был отмечен
+    bool visit(int id)
+    {
+        if (marks[id] == tag)
+            return false;
+        marks[id] = tag;
+        return true;
+    }
+};
+
+// проверяет размер k и количество векторов, возвращает количество возвращаемых соседей
+inline int resultCount(int k, int size)
+{
+    if (k <= 0)
+        throw VectorException("Number of neighbours must be greater than zero");
+
+    return std::min(k, size);
+}
+
+// общее количество элементов count векторов длины dimension
+inline int checkedCapacity(int count, int dimension)
+{
+    if (count < 0)
+        throw VectorException("Capacity must be greater or equal zero");
+
+    if (count > INT_MAX / dimension)
+        throw VectorException("Index is too large");
+
+    return count * dimension;
+}
+
+template<typename V> void writeValue(std::ofstream &stream, const V &value)
+{
+    stream.write(reinterpret_cast<const char *>(&value), sizeof(V));
+}
+
+template<typename V> V readValue(std::ifstream &stream)
+{
+    V value;
+    stream.read(reinterpret_cast<char *>(&value), sizeof(V));
+    if (!stream)
+        throw VectorException("Unexpected end of index file");
+
+    return value;
+}
+
+// проверяет, что до конца файла осталось не меньше bytes байт, чтобы повреждённый размер
+// в заголовке не приводил к выделению памяти под несуществующие данные
+inline void checkRemaining(std::ifstream &stream, long long bytes)
+{
+    std::streampos position = stream.tellg();
+    stream.seekg(0, std::ios::end);
+    std::streampos end = stream.tellg();
+    stream.seekg(position);
+    if (!stream || position < 0 || (long long)(end - position) < bytes)
+        throw VectorException("Unexpected end of index file");
+}
+
+// заголовок файла индекса: сигнатура, версия, размер элемента, размерность и мера
+template<typename T> void writeHeader(std::ofstream &stream, unsigned magic, int dimension, Metric metric)
+{
+    writeValue(stream, magic);
+    writeValue(stream, 1);
+    writeValue(stream, (int)sizeof(T));
+    writeValue(stream, dimension);
+    writeValue(stream, (int)metric);
+}
+
+template<typename T> void readHeader(std::ifstream &stream, unsigned magic, int &dimension, Metric &metric)
+{
+    if (readValue<unsigned>(stream) != magic || readValue<int>(stream) != 1)
+        throw VectorException("Invalid index file");
+
+    if (readValue<int>(stream) != (int)sizeof(T))
+        throw VectorException("Index file element type does not match");
+
+    dimension = readValue<int>(stream);
+    int metricValue = readValue<int>(stream);
+    if (dimension <= 0 || metricValue < L2 || metricValue > COSINE)
+        throw VectorException("Invalid index file");
+
+    metric = (Metric)metricValue;
+}
+
+// копия матрицы запросов по строкам
+template<typename T> MyMatrix<T> rowMajor(const MyMatrix<T> &matrix)
+{
+    return matrix.get_layout() == MyMatrix<T>::ROW_MAJOR ? matrix : matrix.to_layout(MyMatrix<T>::ROW_MAJOR);
+}
+
+} // namespace detail
+
+// Точный поиск полным перебором. Векторы лежат подряд в одном MyVector, поэтому перебор идёт
+// по непрерывной памяти; многопоточный запрос делит векторы между потоками, у каждого из
+// которых своя куча, а пакет запросов делится между потоками по запросам.
+template <typename T> class FlatIndex {
+    static_assert(std::is_floating_point<T>::value, "Index elements must be floating point");
+
+public:
+    // сигнатура файла индекса
+    static const unsigned FILE_MAGIC = 0x4946564d;
+
+private:
+    int dimension;
+    Metric metric;
+    int size;
+    MyVector<T> storage;
+
+    // проверяет длину вектора и возвращает его копию, нормированную для COSINE
+    MyVector<T> prepare(const MyVector<T> &vector) const;
+
+    // просмотреть векторы [begin, end) и добавить подходящие в top
+    void scan(const T *query, int begin, int end, detail::TopK<T> &top) const;
+
+public:
+    // конструктор пустого индекса векторов длины dimension
+    FlatIndex(int dimension, Metric metric = L2);
+
+    // получить длину векторов
+    int get_dimension() const;
+
+    // получить меру близости
+    Metric get_metric() const;
+
+    // получить количество векторов
+    int get_size() const;
+
+    // выделить место под capacity векторов, чтобы добавление не копировало массив
+    void reserve(int capacity);
+
+    // добавить вектор, возвращает его номер
+    int add(const MyVector<T> &vector);
+
+    // добавить строки матрицы как векторы, возвращает номер первого из них
+    int add(const MyMatrix<T> &vectors);
+
+    // получить копию вектора по номеру (для COSINE - нормированного)
+    MyVector<T> get_vector(int id) const;
+
+    // k ближайших к query векторов в порядке возрастания расстояния (не больше get_size())
+    MyVector<Neighbor<T>> search(const MyVector<T> &query, int k, int threadCount = 1) const;
+
+    // k ближайших для каждой строки queries; соседи строки i занимают элементы
+    // [i * m, (i + 1) * m), где m = min(k, get_size())
+    MyVector<Neighbor<T>> search(const MyMatrix<T> &queries, int k, int threadCount = 1) const;
+
+    // сохранить индекс в двоичный файл
+    void save(const std::string &path) const;
+
+    // загрузить индекс из двоичного файла
+    static FlatIndex<T> load(const std::string &path);
+};
+
+// проверяет длину вектора и возвращает его копию, нормированную для COSINE
+template<typename T> MyVector<T> FlatIndex<T>::prepare(const MyVector<T> &vector) const
+{
+    if (vector.get_length() != dimension)
+        throw VectorException("Vector length does not match index dimension");
+
+    MyVector<T> result(vector);
+    if (metric == COSINE)
+        detail::normalize(result.data(), dimension);
+
+    return result;
+}
+
+// просмотреть векторы [begin, end) и добавить подходящие в top
+template<typename T> void FlatIndex<T>::scan(const T *query, int begin, int end, detail::TopK<T> &top) const
+{
+    const T *vectors = storage.data();
+    for(int i = begin; i < end; i++) {
+        T distance = detail::distance(metric, query, vectors + (long long)i * dimension, dimension);
+        if (top.accepts(distance))
+            top.push(i, distance);
+    }
+}
+
+// конструктор пустого индекса векторов длины dimension
+template<typename T> FlatIndex<T>::FlatIndex(int dimension, Metric metric) :
+    dimension(dimension), metric(metric), size(0), storage(0)
+{
+    if (dimension <= 0)
+        throw VectorException("Dimension must be greater than zero");
+}
+
+// получить длину векторов
+template<typename T> int FlatIndex<T>::get_dimension() const
+{
+    return dimension;
+}
+
+// получить меру близости
+template<typename T> Metric FlatIndex<T>::get_metric() const
+{
+    return metric;
+}
+
+// получить количество векторов
+template<typename T> int FlatIndex<T>::get_size() const
+{
+    return size;
+}
+
+// выделить место под capacity векторов, чтобы добавление не копировало массив
+template<typename T> void FlatIndex<T>::reserve(int capacity)
+{
+    int length = detail::checkedCapacity(capacity, dimension);
+    if (length <= storage.get_length())
+        return;
+
+    MyVector<T> grown(length);
+    std::copy(storage.data(), storage.data() + (long long)size * dimension, grown.data());
+    storage = std::move(grown);
+}
+
+// добавить вектор, возвращает его номер
+template<typename T> int FlatIndex<T>::add(const MyVector<T> &vector)
+{
+    MyVector<T> prepared = prepare(vector);
+
+    if ((long long)(size + 1) * dimension > storage.get_length())
+        reserve(std::max(size + 1, (int)std::min<long long>(INT_MAX / dimension, 2LL * size)));
+
+    std::copy(prepared.data(), prepared.data() + dimension, storage.data() + (long long)size * dimension);
+    return size++;
+}
+
+// добавить строки матрицы как векторы, возвращает номер первого из них
+template<typename T> int FlatIndex<T>::add(const MyMatrix<T> &vectors)
+{
+    if (vectors.get_columns() != dimension)
+        throw VectorException("Vector length does not match index dimension");
+
+    if (vectors.get_rows() > INT_MAX / dimension - size)
+        throw VectorException("Index is too large");
+
+    MyMatrix<T> rows = detail::rowMajor(vectors);
+    reserve(size + rows.get_rows());
+
+    int first = size;
+    T *target = storage.data() + (long long)size * dimension;
+    std::copy(rows.data(), rows.data() + (long long)rows.get_rows() * dimension, target);
+    if (metric == COSINE)
+        for(int i = 0; i < rows.get_rows(); i++)
+            detail::normalize(target + (long long)i * dimension, dimension);
+
+    size += rows.get_rows();
+    return first;
+}
+
+// получить копию вектора по номеру (для COSINE - нормированного)
+template<typename T> MyVector<T> FlatIndex<T>::get_vector(int id) const
+{
+    if (id < 0 || id >= size)
+        throw VectorException("Index out of range");
+
+    MyVector<T> result(dimension);
+    const T *source = storage.data() + (long long)id * dimension;
+    std::copy(source, source + dimension, result.data());
+    return result;
+}
+
+// k ближайших к query векторов в порядке возрастания расстояния (не больше get_size())
+template<typename T> MyVector<Neighbor<T>> FlatIndex<T>::search(const MyVector<T> &query, int k, int threadCount) const
+{
+    int count = detail::resultCount(k, size);
+    MyVector<T> prepared = prepare(query);
+    MyVector<Neighbor<T>> result(count);
+    if (count == 0)
+        return result;
+
+    detail::TopK<T> top(count);
+    if (threadCount <= 1) {
+        scan(prepared.data(), 0, size, top);
+    } else {
+        // у каждого потока своя куча, кучи объединяются после завершения потоков
+        std::vector<detail::TopK<T>> parts(threadCount, detail::TopK<T>(count));
+        MyVectorAlgorithms::detail::runParallel(threadCount, size, [&](int part, int begin, int end) {
+            scan(prepared.data(), begin, end, parts[part]);
+        });
+        for(const detail::TopK<T> &part : parts)
+            top.merge(part);
+    }
+
+    top.extract(result.data());
+    return result;
+}
+
+// k ближайших для каждой строки queries
+template<typename T> MyVector<Neighbor<T>> FlatIndex<T>::search(const MyMatrix<T> &queries, int k, int threadCount) const
+{
+    if (queries.get_columns() != dimension)
+        throw VectorException("Vector length does not match index dimension");
+
+    int count = detail::resultCount(k, size);
+    MyMatrix<T> rows = detail::rowMajor(queries);
+    if (metric == COSINE)
+        for(int i = 0; i < rows.get_rows(); i++)
+            detail::normalize(rows.data() + (long long)i * dimension, dimension);
+
+    if (count == 0)
+        return MyVector<Neighbor<T>>(0);
+
+    MyVector<Neighbor<T>> result(detail::checkedCapacity(rows.get_rows(), count));
+
+    MyVectorAlgorithms::detail::runParallel(std::max(1, threadCount), rows.get_rows(), [&](int, int begin, int end) {
+        for(int q = begin; q < end; q++) {
+            detail::TopK<T> top(count);
+            scan(rows.data() + (long long)q * dimension, 0, size, top);
+            top.extract(result.data() + (long long)q * count);
+        }
+    });
+
+    return result;
+}
+
+// сохранить индекс в двоичный файл
+template<typename T> void FlatIndex<T>::save(const std::string &path) const
+{
+    std::ofstream stream(path, std::ios::binary);
+    if (!stream)
+        throw VectorException("Cannot open index file");
+
+    detail::writeHeader<T>(stream, FILE_MAGIC, dimension, metric);
+    detail::writeValue(stream, size);
+    stream.write(reinterpret_cast<const char *>(storage.data()), (std::streamsize)size * dimension * sizeof(T));
+
+    if (!stream)
+        throw VectorException("Cannot write index file");
+}
+
+// загрузить индекс из двоичного файла
+template<typename T> FlatIndex<T> FlatIndex<T>::load(const std::string &path)
+{
+    std::ifstream stream(path, std::ios::binary);
+    if (!stream)
+        throw VectorException("Cannot open index file");
+
+    int dimension;
+    Metric metric;
+    detail::readHeader<T>(stream, FILE_MAGIC, dimension, metric);
+
+    FlatIndex<T> index(dimension, metric);
+    int size = detail::readValue<int>(stream);
+    if (size < 0)
+        throw VectorException("Invalid index file");
+
+    detail::checkRemaining(stream, (long long)size * dimension * (long long)sizeof(T));
+    index.reserve(size);
+    stream.read(reinterpret_cast<char *>(index.storage.data()), (std::streamsize)size * dimension * sizeof(T));
+    if (!stream)
+        throw VectorException("Unexpected end of index file");
+
+    index.size = size;
+    return index;
+}
+
+// Приближённый поиск по иерархическому графу близости (HNSW). Каждый вектор получает
+// случайный уровень с экспоненциально убывающей вероятностью и на каждом уровне до своего
+// связывается с ближайшими соседями, отобранными эвристикой разнообразия. Поиск спускается
+// жадно с верхнего уровня, а на нулевом уровне просматривает ef лучших кандидатов.
+// Списки соседей нулевого уровня лежат в одном MyVector<int> с шагом 1 + 2 * maxLinks
+// (количество и номера), списки верхних уровней - в общем массиве с шагом 1 + maxLinks.
+// Многопоточное построение защищает списки фиксированным набором мьютексов, узел id
+// использует мьютекс id % LOCK_STRIPES; запросы можно выполнять одновременно друг с
+// другом, но не с добавлением векторов.
+template <typename T> class HnswIndex {
+    static_assert(std::is_floating_point<T>::value, "Index elements must be floating point");
+
+public:
+    // сигнатура файла индекса
+    static const unsigned FILE_MAGIC = 0x4e48564d;
+
+    // наибольший уровень узла
+    static const int MAX_LEVEL = 30;
+
+    // количество мьютексов, защищающих списки соседей (степень двойки)
+    static const int LOCK_STRIPES = 1024;
+
+private:
+    int dimension;
+    Metric metric;
+    int maxLinks;
+    int efConstruction;
+    unsigned long long seed;
+    int size;
+    int capacity;
+    MyVector<T> storage;
+
+    // уровень каждого узла; списки соседей нулевого уровня по capacity узлам; для узлов с
+    // уровнем выше нулевого - смещение их списков в upperLinks, иначе -1
+    std::vector<int> levels;
+    MyVector<int> baseLinks;
+    std::vector<int> upperOffsets;
+    std::vector<int> upperLinks;
+
+    std::unique_ptr<std::mutex[]> nodeLocks;
+    std::unique_ptr<std::mutex> entryLock;
+    int entryPoint;
+    int maxLevel;
+
+    // вектор узла
+    const T *vectorOf(int id) const;
+
+    // расстояние от query до узла
+    T distanceTo(const T *query, int id) const;
+
+    // случайный уровень узла, зависящий только от seed и номера узла
+    int randomLevel(int id) const;
+
+    // наибольшее число соседей узла на уровне
+    int linkLimit(int level) const;
+
+    // список соседей узла на уровне: количество, за которым следуют номера
+    int *linksOf(int id, int level);
+    const int *linksOf(int id, int level) const;
+
+    // мьютекс, защищающий списки соседей узла
+    std::mutex &lockOf(int id) const;
+
+    // задать уровень узла и выделить пустые списки соседей на уровнях 0..level
+    void allocateLinks(int id, int level);
+
+    // скопировать список соседей узла, под мьютексом узла при многопоточном построении
+    void copyLinks(int id, int level, std::vector<int> &out, bool locked) const;
+
+    // жадный спуск с уровня top до уровня bottom + 1, возвращает ближайший найденный узел
+    int greedyDescent(const T *query, int entry, int top, int bottom, bool locked) const;
+
+    // ef ближайших к query узлов уровня level в порядке возрастания расстояния
+    std::vector<Neighbor<T>> searchLayer(const T *query, int entry, int ef, int level, bool locked) const;
+
+    // эвристика выбора не более limit соседей из упорядоченных кандидатов: кандидат
+    // отбрасывается, если он ближе к уже выбранному соседу, чем к вставляемому узлу
+    std::vector<int> selectNeighbors(const std::vector<Neighbor<T>> &candidates, int limit) const;
+
+    // добавить ребро from -> to на уровне level, сокращая список при переполнении
+    void connect(int from, int to, int level, bool locked);
+
+    // связать уже записанный в storage узел с графом
+    void insert(int id, bool locked);
+
+    // записать вектор в storage и выбрать уровень узла
+    void place(int id, const T *vector);
+
+public:
+    // конструктор пустого индекса; maxLinks - число соседей на уровнях выше нулевого (на
+    // нулевом вдвое больше), efConstruction - ширина поиска при построении
+    HnswIndex(int dimension, Metric metric = L2, int maxLinks = 16, int efConstruction = 200,
+              unsigned long long seed = 42);
+
+    HnswIndex(const HnswIndex<T> &index) = delete;
+    HnswIndex<T> &operator =(const HnswIndex<T> &index) = delete;
+    HnswIndex(HnswIndex<T> &&index) = default;
+
+    // получить длину векторов
+    int get_dimension() const;
+
+    // получить меру близости
+    Metric get_metric() const;
+
+    // получить количество векторов
+    int get_size() const;
+
+    // выделить место под capacity векторов
+    void reserve(int capacity);
+
+    // добавить вектор, возвращает его номер
+    int add(const MyVector<T> &vector);
+
+    // добавить строки матрицы как векторы, возвращает номер первого из них;
+    // threadCount > 1 включает многопоточное построение
+    int add(const MyMatrix<T> &vectors, int threadCount = 1);
+
+    // получить копию вектора по номеру (для COSINE - нормированного)
+    MyVector<T> get_vector(int id) const;
+
+    // приближённо k ближайших к query векторов в порядке возрастания расстояния;
+    // ef - ширина поиска, большее значение точнее, но медленнее. Если поиск по графу
+    // достиг меньше min(k, get_size()) узлов, результат короче
+    MyVector<Neighbor<T>> search(const MyVector<T> &query, int k, int ef = 64) const;
+
+    // приближённо k ближайших для каждой строки queries, размещение как у FlatIndex;
+    // недостающие соседи строки заполняются значением {-1, +inf} в её конце
+    MyVector<Neighbor<T>> search(const MyMatrix<T> &queries, int k, int ef = 64, int threadCount = 1) const;
+
+    // сохранить индекс в двоичный файл
+    void save(const std::string &path) const;
+
+    // загрузить индекс из двоичного файла
+    static HnswIndex<T> load(const std::string &path);
+};
+
+// вектор узла
+template<typename T> const T *HnswIndex<T>::vectorOf(int id) const
+{
+    return storage.data() + (long long)id * dimension;
+}
+
+// расстояние от query до узла
+template<typename T> T HnswIndex<T>::distanceTo(const T *query, int id) const
+{
+    return detail::distance(metric, query, vectorOf(id), dimension);
+}
+
+// случайный уровень узла, зависящий только от seed и номера узла
+template<typename T> int HnswIndex<T>::randomLevel(int id) const
+{
+    unsigned long long bits = seed ^ ((unsigned long long)id * 0x9e3779b97f4a7c15ULL);
+    bits = (bits ^ (bits >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    bits = (bits ^ (bits >> 27)) * 0x94d049bb133111ebULL;
+    bits ^= bits >> 31;
+
+    // равномерное число из (0, 1]
+    double unit = (double)((bits >> 11) + 1) * (1.0 / 9007199254740992.0);
+    int level = (int)(-std::log(unit) / std::log((double)maxLinks));
+    return level < MAX_LEVEL ? level : MAX_LEVEL;
+}
+
+// наибольшее число соседей узла на уровне
+template<typename T> int HnswIndex<T>::linkLimit(int level) const
+{
+    return level == 0 ? 2 * maxLinks : maxLinks;
+}
+
+// список соседей узла на уровне
+template<typename T> int *HnswIndex<T>::linksOf(int id, int level)
+{
+    if (level == 0)
+        return baseLinks.data() + (long long)id * (1 + 2 * maxLinks);
+
+    return upperLinks.data() + upperOffsets[id] + (long long)(level - 1) * (1 + maxLinks);
+}
+
+template<typename T> const int *HnswIndex<T>::linksOf(int id, int level) const
+{
+    if (level == 0)
+        return baseLinks.data() + (long long)id * (1 + 2 * maxLinks);
+
+    return upperLinks.data() + upperOffsets[id] + (long long)(level - 1) * (1 + maxLinks);
+}
+
+// мьютекс, защищающий списки соседей узла; одновременно поток держит не больше одного
+// такого мьютекса, поэтому общий мьютекс у разных узлов не приводит к взаимной блокировке
+template<typename T> std::mutex &HnswIndex<T>::lockOf(int id) const
+{
+    return nodeLocks[id & (LOCK_STRIPES - 1)];
+}
+
+// задать уровень узла и выделить пустые списки соседей на уровнях 0..level
+template<typename T> void HnswIndex<T>::allocateLinks(int id, int level)
+{
+    levels[id] = level;
+    linksOf(id, 0)[0] = 0;
+
+    if (level == 0) {
+        upperOffsets[id] = -1;
+        return;
+    }
+
+    upperOffsets[id] = (int)upperLinks.size();
+    upperLinks.resize(upperLinks.size() + (size_t)level * (1 + maxLinks));
+    for(int layer = 1; layer <= level; layer++)
+        linksOf(id, layer)[0] = 0;
+}
+
+// скопировать список соседей узла
+template<typename T> void HnswIndex<T>::copyLinks(int id, int level, std::vector<int> &out, bool locked) const
+{
+    std::unique_lock<std::mutex> guard(lockOf(id), std::defer_lock);
+    if (locked)
+        guard.lock();
+
+    const int *list = linksOf(id, level);
+    out.assign(list + 1, list + 1 + list[0]);
+}
+
+// жадный спуск с уровня top до уровня bottom + 1
+template<typename T> int HnswIndex<T>::greedyDescent(const T *query, int entry, int top, int bottom, bool locked) const
+{
+    int current = entry;
+    T currentDistance = distanceTo(query, current);
+    std::vector<int> neighbors;
+
+    for(int level = top; level > bottom; level--) {
+        bool changed = true;
+        while (changed) {
+            changed = false;
+            copyLinks(current, level, neighbors, locked);
+            for(int neighbor : neighbors) {
+                T distance = distanceTo(query, neighbor);
+                if (distance < currentDistance) {
+                    current = neighbor;
+                    currentDistance = distance;
+                    changed = true;
+                }
+            }
+        }
+    }
+
+    return current;
+}
+
+// ef ближайших к query узлов уровня level в порядке возрастания расстояния
+template<typename T> std::vector<Neighbor<T>> HnswIndex<T>::searchLayer(const T *query, int entry, int ef,
+                                                                        int level, bool locked) const
+{
+    struct Farther {
+        bool operator ()(const Neighbor<T> &a, const Neighbor<T> &b) const
+        {
+            return a.distance > b.distance;
+        }
+    };
+    struct Closer {
+        bool operator ()(const Neighbor<T> &a, const Neighbor<T> &b) const
+        {
+            return a.distance < b.distance;
+        }
+    };
+
+    // метки посещённых узлов переиспользуются между поисками одного потока
+    static thread_local detail::VisitedSet visited;
+    visited.reset(capacity);
+
+    // candidates - очередь на просмотр, ближайший сверху; found - лучшие ef, дальний сверху
+    std::priority_queue<Neighbor<T>, std::vector<Neighbor<T>>, Farther> candidates;
+    std::priority_queue<Neighbor<T>, std::vector<Neighbor<T>>, Closer> found;
+
+    Neighbor<T> start = {entry, distanceTo(query, entry)};
+    visited.visit(entry);
+    candidates.push(start);
+    found.push(start);
+
+    std::vector<int> neighbors;
+    while (!candidates.empty()) {
+        Neighbor<T> current = candidates.top();
+        if (current.distance > found.top().distance && (int)found.size() >= ef)
+            break;
+        candidates.pop();
+
+        copyLinks(current.id, level, neighbors, locked);
+        for(size_t i = 0; i < neighbors.size(); i++) {
+            if (i + 1 < neighbors.size())
+                MYVECTOR_PREFETCH_READ(vectorOf(neighbors[i + 1]));
+
+            int neighbor = neighbors[i];
+            if (!visited.visit(neighbor))
+                continue;
+
+            T distance = distanceTo(query, neighbor);
+            if ((int)found.size() < ef || distance < found.top().distance) {
+                candidates.push(Neighbor<T>{neighbor, distance});
+                found.push(Neighbor<T>{neighbor, distance});
+                if ((int)found.size() > ef)
+                    found.pop();
+            }
+        }
+    }
+
+    std::vector<Neighbor<T>> result(found.size());
+    for(int i = (int)result.size() - 1; i >= 0; i--) {
+        result[i] = found.top();
+        found.pop();
+    }
+
+    return result;
+}
+
+// эвристика выбора не более limit соседей из упорядоченных кандидатов
+template<typename T> std::vector<int> HnswIndex<T>::selectNeighbors(const std::vector<Neighbor<T>> &candidates,
+                                                                    int limit) const
+{
+    std::vector<int> selected;
+    for(const Neighbor<T> &candidate : candidates) {
+        if ((int)selected.size() >= limit)
+            break;
+
+        bool diverse = true;
+        for(int id : selected)
+            if (distanceTo(vectorOf(candidate.id), id) < candidate.distance) {
+                diverse = false;
+                break;
+            }
+
+        if (diverse)
+            selected.push_back(candidate.id);
+    }
+
+    return selected;
+}
+
+// добавить ребро from -> to на уровне level, сокращая список при переполнении
+template<typename T> void HnswIndex<T>::connect(int from, int to, int level, bool locked)
+{
+    std::unique_lock<std::mutex> guard(lockOf(from), std::defer_lock);
+    if (locked)
+        guard.lock();
+
+    int *list = linksOf(from, level);
+    if (list[0] < linkLimit(level)) {
+        list[1 + list[0]++] = to;
+        return;
+    }
+
+    std::vector<Neighbor<T>> candidates;
+    candidates.reserve(list[0] + 1);
+    const T *origin = vectorOf(from);
+    for(int i = 1; i <= list[0]; i++)
+        candidates.push_back(Neighbor<T>{list[i], distanceTo(origin, list[i])});
+    candidates.push_back(Neighbor<T>{to, distanceTo(origin, to)});
+    std::sort(candidates.begin(), candidates.end(), [](const Neighbor<T> &a, const Neighbor<T> &b) {
+        return a.distance < b.distance;
+    });
+
+    std::vector<int> selected = selectNeighbors(candidates, linkLimit(level));
+    list[0] = (int)selected.size();
+    std::copy(selected.begin(), selected.end(), list + 1);
+}
+
+// связать уже записанный в storage узел с графом
+template<typename T> void HnswIndex<T>::insert(int id, bool locked)
+{
+    int level = levels[id];
+
+    // пока новый узел поднимает верхний уровень графа, точка входа остаётся заблокированной
+    std::unique_lock<std::mutex> entryGuard(*entryLock);
+    int entry = entryPoint;
+    int top = maxLevel;
+    if (entry < 0) {
+        entryPoint = id;
+        maxLevel = level;
+        return;
+    }
+    if (level <= top)
+        entryGuard.unlock();
+
+    const T *query = vectorOf(id);
+    int current = greedyDescent(query, entry, top, level, locked);
+
+    for(int layer = std::min(level, top); layer >= 0; layer--) {
+        std::vector<Neighbor<T>> candidates = searchLayer(query, current, efConstruction, layer, locked);
+        std::vector<int> selected = selectNeighbors(candidates, maxLinks);
+
+        {
+            std::unique_lock<std::mutex> guard(lockOf(id), std::defer_lock);
+            if (locked)
+                guard.lock();
+            int *list = linksOf(id, layer);
+            list[0] = (int)selected.size();
+            std::copy(selected.begin(), selected.end(), list + 1);
+        }
+
+        for(int neighbor : selected)
+            connect(neighbor, id, layer, locked);
+
+        current = candidates.front().id;
+    }
+
+    if (level > top) {
+        entryPoint = id;
+        maxLevel = level;
+    }
+}
+
+// записать вектор в storage и выбрать уровень узла
+template<typename T> void HnswIndex<T>::place(int id, const T *vector)
+{
+    T *target = storage.data() + (long long)id * dimension;
+    std::copy(vector, vector + dimension, target);
+    if (metric == COSINE)
+        detail::normalize(target, dimension);
+
+    allocateLinks(id, randomLevel(id));
+}
+
+// конструктор пустого индекса
+template<typename T> HnswIndex<T>::HnswIndex(int dimension, Metric metric, int maxLinks, int efConstruction,
+                                             unsigned long long seed) :
+    dimension(dimension), metric(metric), maxLinks(maxLinks), efConstruction(efConstruction), seed(seed),
+    size(0), capacity(0), storage(0), baseLinks(0), nodeLocks(new std::mutex[LOCK_STRIPES]),
+    entryLock(new std::mutex()), entryPoint(-1), maxLevel(-1)
+{
+    if (dimension <= 0)
+        throw VectorException("Dimension must be greater than zero");
+
+    if (maxLinks < 2 || efConstruction <= 0)
+        throw VectorException("Invalid graph parameters");
+}
+
+// получить длину векторов
+template<typename T> int HnswIndex<T>::get_dimension() const
+{
+    return dimension;
+}
+
+// получить меру близости
+template<typename T> Metric HnswIndex<T>::get_metric() const
+{
+    return metric;
+}
+
+// получить количество векторов
+template<typename T> int HnswIndex<T>::get_size() const
+{
+    return size;
+}
+
+// выделить место под capacity векторов
+template<typename T> void HnswIndex<T>::reserve(int capacity)
+{
+    int length = detail::checkedCapacity(capacity, dimension);
+    if (capacity <= this->capacity)
+        return;
+
+    int stride = 1 + 2 * maxLinks;
+    if (capacity > INT_MAX / stride)
+        throw VectorException("Index is too large");
+
+    MyVector<T> grown(length);
+    std::copy(storage.data(), storage.data() + (long long)size * dimension, grown.data());
+    storage = std::move(grown);
+
+    MyVector<int> grownLinks(capacity * stride);
+    std::copy(baseLinks.data(), baseLinks.data() + (long long)size * stride, grownLinks.data());
+    baseLinks = std::move(grownLinks);
+
+    levels.resize(capacity);
+    upperOffsets.resize(capacity);
+    this->capacity = capacity;
+}
+
+// добавить вектор, возвращает его номер
+template<typename T> int HnswIndex<T>::add(const MyVector<T> &vector)
+{
+    if (vector.get_length() != dimension)
+        throw VectorException("Vector length does not match index dimension");
+
+    if (size == capacity)
+        reserve(std::max(size + 1, (int)std::min<long long>(INT_MAX / dimension, 2LL * size)));
+
+    place(size, vector.data());
+    insert(size, false);
+    return size++;
+}
+
+// добавить строки матрицы как векторы, возвращает номер первого из них
+template<typename T> int HnswIndex<T>::add(const MyMatrix<T> &vectors, int threadCount)
+{
+    if (vectors.get_columns() != dimension)
+        throw VectorException("Vector length does not match index dimension");
+
+    if (vectors.get_rows() > INT_MAX / dimension - size)
+        throw VectorException("Index is too large");
+
+    MyMatrix<T> rows = detail::rowMajor(vectors);
+    int first = size;
+    int count = rows.get_rows();
+    reserve(size + count);
+
+    for(int i = 0; i < count; i++)
+        place(first + i, rows.data() + (long long)i * dimension);
+
+    if (threadCount <= 1) {
+        for(int i = 0; i < count; i++)
+            insert(first + i, false);
+    } else {
+        // узлы раздаются потокам по порядку номеров, чтобы граф рос равномерно
+        std::atomic<int> next(first);
+        MyVectorAlgorithms::detail::runParallel(threadCount, count, [&](int, int, int) {
+            for(int id = next++; id < first + count; id = next++)
+                insert(id, true);
+        });
+    }
+
+    size += count;
+    return first;
+}
+
+// получить копию вектора по номеру (для COSINE - нормированного)
+template<typename T> MyVector<T> HnswIndex<T>::get_vector(int id) const
+{
+    if (id < 0 || id >= size)
+        throw VectorException("Index out of range");
+
+    MyVector<T> result(dimension);
+    std::copy(vectorOf(id), vectorOf(id) + dimension, result.data());
+    return result;
+}
+
+// приближённо k ближайших к query векторов в порядке возрастания расстояния
+template<typename T> MyVector<Neighbor<T>> HnswIndex<T>::search(const MyVector<T> &query, int k, int ef) const
+{
+    if (query.get_length() != dimension)
+        throw VectorException("Vector length does not match index dimension");
+
+    int count = detail::resultCount(k, size);
+    if (count == 0)
+        return MyVector<Neighbor<T>>(0);
+
+    MyVector<T> prepared(query);
+    if (metric == COSINE)
+        detail::normalize(prepared.data(), dimension);
+
+    int current = greedyDescent(prepared.data(), entryPoint, maxLevel, 0, false);
+    std::vector<Neighbor<T>> found = searchLayer(prepared.data(), current, std::max(ef, count), 0, false);
+
+    // граф с малым maxLinks может быть несвязным, тогда найдено меньше count узлов
+    MyVector<Neighbor<T>> result(std::min(count, (int)found.size()));
+    std::copy(found.begin(), found.begin() + result.get_length(), result.data());
+    return result;
+}
+
+// приближённо k ближайших для каждой строки queries
+template<typename T> MyVector<Neighbor<T>> HnswIndex<T>::search(const MyMatrix<T> &queries, int k, int ef,
+                                                                int threadCount) const
+{
+    if (queries.get_columns() != dimension)
+        throw VectorException("Vector length does not match index dimension");
+
+    int count = detail::resultCount(k, size);
+    MyMatrix<T> rows = detail::rowMajor(queries);
+    if (count == 0)
+        return MyVector<Neighbor<T>>(0);
+
+    MyVector<Neighbor<T>> result(detail::checkedCapacity(rows.get_rows(), count));
+
+    MyVectorAlgorithms::detail::runParallel(std::max(1, threadCount), rows.get_rows(), [&](int, int begin, int end) {
+        MyVector<T> query(dimension);
+        for(int q = begin; q < end; q++) {
+            T *target = query.data();
+            std::copy(rows.data() + (long long)q * dimension, rows.data() + (long long)(q + 1) * dimension, target);
+            MyVector<Neighbor<T>> found = search(query, count, ef);
+            Neighbor<T> *row = result.data() + (long long)q * count;
+            std::copy(found.data(), found.data() + found.get_length(), row);
+            std::fill(row + found.get_length(), row + count,
+                      Neighbor<T>{-1, std::numeric_limits<T>::infinity()});
+        }
+    });
+
+    return result;
+}
+
+// сохранить индекс в двоичный файл
+template<typename T> void HnswIndex<T>::save(const std::string &path) const
+{
+    std::ofstream stream(path, std::ios::binary);
+    if (!stream)
+        throw VectorException("Cannot open index file");
+
+    detail::writeHeader<T>(stream, FILE_MAGIC, dimension, metric);
+    detail::writeValue(stream, maxLinks);
+    detail::writeValue(stream, efConstruction);
+    detail::writeValue(stream, seed);
+    detail::writeValue(stream, size);
+    detail::writeValue(stream, entryPoint);
+    detail::writeValue(stream, maxLevel);
+    stream.write(reinterpret_cast<const char *>(storage.data()), (std::streamsize)size * dimension * sizeof(T));
+
+    for(int id = 0; id < size; id++) {
+        detail::writeValue(stream, levels[id]);
+        for(int level = 0; level <= levels[id]; level++) {
+            const int *list = linksOf(id, level);
+            stream.write(reinterpret_cast<const char *>(list), (std::streamsize)(1 + list[0]) * sizeof(int));
+        }
+    }
+
+    if (!stream)
+        throw VectorException("Cannot write index file");
+}
+
+// загрузить индекс из двоичного файла
+template<typename T> HnswIndex<T> HnswIndex<T>::load(const std::string &path)
+{
+    std::ifstream stream(path, std::ios::binary);
+    if (!stream)
+        throw VectorException("Cannot open index file");
+
+    int dimension;
+    Metric metric;
+    detail::readHeader<T>(stream, FILE_MAGIC, dimension, metric);
+    int maxLinks = detail::readValue<int>(stream);
+    int efConstruction = detail::readValue<int>(stream);
+    unsigned long long seed = detail::readValue<unsigned long long>(stream);
+
+    HnswIndex<T> index(dimension, metric, maxLinks, efConstruction, seed);
+    int size = detail::readValue<int>(stream);
+    int entryPoint = detail::readValue<int>(stream);
+    int maxLevel = detail::readValue<int>(stream);
+    if (size < 0 || entryPoint < -1 || entryPoint >= size || (size > 0) != (entryPoint >= 0))
+        throw VectorException("Invalid index file");
+
+    // у каждого узла кроме вектора записаны хотя бы уровень и длина списка нулевого уровня
+    detail::checkRemaining(stream, (long long)size * ((long long)dimension * sizeof(T) + 2 * sizeof(int)));
+    index.reserve(size);
+    stream.read(reinterpret_cast<char *>(index.storage.data()), (std::streamsize)size * dimension * sizeof(T));
+
+    for(int id = 0; id < size; id++) {
+        int level = detail::readValue<int>(stream);
+        if (level < 0 || level > MAX_LEVEL)
+            throw VectorException("Invalid index file");
+
+        index.allocateLinks(id, level);
+        for(int layer = 0; layer <= level; layer++) {
+            int count = detail::readValue<int>(stream);
+            if (count < 0 || count > index.linkLimit(layer))
+                throw VectorException("Invalid index file");
+
+            int *list = index.linksOf(id, layer);
+            list[0] = count;
+            stream.read(reinterpret_cast<char *>(list + 1), (std::streamsize)count * sizeof(int));
+        }
+    }
+
+    if (!stream)
+        throw VectorException("Unexpected end of index file");
+
+    // номера соседей и точка входа проверяются, чтобы повреждённый файл не приводил к
+    // выходу за границы при поиске; сосед на уровне layer должен сам иметь этот уровень
+    for(int id = 0; id < size; id++)
+        for(int layer = 0; layer <= index.levels[id]; layer++) {
+            const int *list = index.linksOf(id, layer);
+            for(int i = 1; i <= list[0]; i++)
+                if (list[i] < 0 || list[i] >= size || index.levels[list[i]] < layer)
+                    throw VectorException("Invalid index file");
+        }
+
+    if (size > 0 && index.levels[entryPoint] != maxLevel)
+        throw VectorException("Invalid index file");
+
+    index.size = size;
+    index.entryPoint = entryPoint;
+    index.maxLevel = maxLevel;
+    return index;
+}
+
+} // namespace MyVectorIndex
+
+#endif // MyVectorIndex_H
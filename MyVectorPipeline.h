@@ -0,0 +1,451 @@
+#ifndef MyVectorPipeline_H
+#define MyVectorPipeline_H
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <exception>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "MyVector.h"
+#include "VectorException.h"
+
+// Потоковая обработка данных, не помещающихся в память. Источник читает данные порциями в
+// два переиспользуемых буфера MyVector: пока один обрабатывается цепочкой этапов, фоновый
+// поток заполняет второй. Обработанная порция без копирования обменивается с одним из двух
+// буферов записи, которые отдельный поток передаёт приёмнику, так что чтение, обработка и
+// запись идут одновременно, а расход памяти ограничен четырьмя порциями. Для источника, каждого этапа и приёмника собирается
+// время работы и пропускная способность.
+template <typename T> class MyVectorPipeline {
+public:
+    // источник: заполняет буфер и возвращает количество записанных элементов, 0 - конец данных
+    typedef std::function<int(MyVector<T> &buffer)> Source;
+
+    // этап: изменяет первые count элементов порции
+    typedef std::function<void(MyVector<T> &chunk, int count)> Stage;
+
+    // приёмник: получает первые count элементов обработанной порции; после последней порции
+    // run() один раз вызывает его с count == 0, чтобы приёмник мог завершить вывод. Приёмник
+    // вызывается в отдельном потоке записи, одновременно с этапами обработки
+    typedef std::function<void(const MyVector<T> &chunk, int count)> Sink;
+
+    // статистика одного этапа
+    struct StageStats {
+        std::string name;
+        long long elements;
+        double seconds;
+
+        // элементов в секунду
+        double throughput() const
+        {
+            return seconds > 0 ? elements / seconds : 0;
+        }
+    };
+
+private:
+    int chunkSize;
+    Source source;
+    Sink sink;
+    std::vector<std::string> stageNames;
+    std::vector<Stage> stages;
+    std::vector<StageStats> stats;
+
+    // добавить время работы к статистике этапа
+    static void account(StageStats &stats, int count, std::chrono::steady_clock::time_point start);
+
+public:
+    // конструктор с указанием размера порции
+    explicit MyVectorPipeline(int chunkSize);
+
+    // задать источник данных
+    MyVectorPipeline<T> &set_source(const Source &source);
+
+    // задать приёмник результата
+    MyVectorPipeline<T> &set_sink(const Sink &sink);
+
+    // добавить произвольный этап обработки
+    MyVectorPipeline<T> &add_stage(const std::string &name, const Stage &stage);
+
+    // добавить этап *=, каждый элемент домножается на value
+    MyVectorPipeline<T> &add_multiply(const T &value);
+
+    // добавить этап /=, каждый элемент делится на value
+    MyVectorPipeline<T> &add_divide(const T &value);
+
+    // добавить этап поэлементного вычитания vector (длины chunkSize) из каждой порции
+    MyVectorPipeline<T> &add_subtract(const MyVector<T> &vector);
+
+    // добавить свёртку элементов: result = combine(result, x) для каждого элемента;
+    // result должен оставаться доступным до завершения run()
+    MyVectorPipeline<T> &add_reduction(const std::string &name, T &result,
+                                       const std::function<T(const T &, const T &)> &combine);
+
+    // добавить подсчёт суммы всех элементов в result
+    MyVectorPipeline<T> &add_sum(T &result);
+
+    // выполнить обработку всех данных источника
+    void run();
+
+    // получить статистику последнего запуска: источник, этапы и приёмник
+    const std::vector<StageStats> &get_stats() const;
+
+    // вывести статистику последнего запуска
+    void print_stats(std::ostream &os) const;
+
+    // источник, читающий элементы из двоичного файла
+    static Source file_source(const std::string &path);
+
+    // источник, вычисляющий элемент по его номеру; total - общее количество элементов
+    static Source generator_source(const std::function<T(long long)> &generator, long long total);
+
+    // приёмник, записывающий элементы в двоичный файл
+    static Sink file_sink(const std::string &path);
+};
+
+// добавить время работы к статистике этапа
+template<typename T> void MyVectorPipeline<T>::account(StageStats &stats, int count,
+                                                       std::chrono::steady_clock::time_point start)
+{
+    stats.elements += count;
+    stats.seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// конструктор с указанием размера порции
+template<typename T> MyVectorPipeline<T>::MyVectorPipeline(int chunkSize) :
+    chunkSize(chunkSize)
+{
+    if (chunkSize <= 0)
+        throw VectorException("Chunk size must be greater than zero");
+}
+
+// задать источник данных
+template<typename T> MyVectorPipeline<T> &MyVectorPipeline<T>::set_source(const Source &source)
+{
+    this->source = source;
+    return *this;
+}
+
+// задать приёмник результата
+template<typename T> MyVectorPipeline<T> &MyVectorPipeline<T>::set_sink(const Sink &sink)
+{
+    this->sink = sink;
+    return *this;
+}
+
+// добавить произвольный этап обработки
+template<typename T> MyVectorPipeline<T> &MyVectorPipeline<T>::add_stage(const std::string &name, const Stage &stage)
+{
+    stageNames.push_back(name);
+    stages.push_back(stage);
+    return *this;
+}
+
+// добавить этап *=, каждый элемент домножается на value
+template<typename T> MyVectorPipeline<T> &MyVectorPipeline<T>::add_multiply(const T &value)
+{
+    // хвост неполной последней порции тоже умножается, но он не передаётся дальше
+    return add_stage("multiply", [value](MyVector<T> &chunk, int) {
+        chunk *= value;
+    });
+}
+
+// добавить этап /=, каждый элемент делится на value
+template<typename T> MyVectorPipeline<T> &MyVectorPipeline<T>::add_divide(const T &value)
+{
+    return add_stage("divide", [value](MyVector<T> &chunk, int) {
+        chunk /= value;
+    });
+}
+
+// добавить этап поэлементного вычитания vector (длины chunkSize) из каждой порции
+template<typename T> MyVectorPipeline<T> &MyVectorPipeline<T>::add_subtract(const MyVector<T> &vector)
+{
+    if (vector.get_length() != chunkSize)
+        throw VectorException("Vector lengths must be equal");
+
+    // operator -= выделяет новый массив на каждый вызов, axpy вычитает на месте
+    std::shared_ptr<MyVector<T>> subtrahend = std::make_shared<MyVector<T>>(vector);
+    return add_stage("subtract", [subtrahend](MyVector<T> &chunk, int) {
+        chunk.axpy(T(-1), *subtrahend);
+    });
+}
+
+// добавить свёртку элементов: result = combine(result, x) для каждого элемента
+template<typename T> MyVectorPipeline<T> &MyVectorPipeline<T>::add_reduction(const std::string &name, T &result,
+                                                                             const std::function<T(const T &, const T &)> &combine)
+{
+    T *target = &result;
+    return add_stage(name, [target, combine](MyVector<T> &chunk, int count) {
+        const T *data = static_cast<const MyVector<T> &>(chunk).data();
+        T accumulator = *target;
+        for(int i = 0; i < count; i++)
+            accumulator = combine(accumulator, data[i]);
+        *target = accumulator;
+    });
+}
+
+// добавить подсчёт суммы всех элементов в result
+template<typename T> MyVectorPipeline<T> &MyVectorPipeline<T>::add_sum(T &result)
+{
+    T *target = &result;
+    return add_stage("sum", [target](MyVector<T> &chunk, int count) {
+        const T *data = static_cast<const MyVector<T> &>(chunk).data();
+        T accumulator = T();
+        for(int i = 0; i < count; i++)
+            accumulator += data[i];
+        *target += accumulator;
+    });
+}
+
+// выполнить обработку всех данных источника
+template<typename T> void MyVectorPipeline<T>::run()
+{
+    if (!source)
+        throw VectorException("Pipeline source is not set");
+
+    stats.clear();
+    stats.push_back(StageStats{"source", 0, 0});
+    for(const std::string &name : stageNames)
+        stats.push_back(StageStats{name, 0, 0});
+    stats.push_back(StageStats{"sink", 0, 0});
+
+    // два буфера чтения: пока один обрабатывается, фоновый поток заполняет другой
+    const int BUFFER_COUNT = 2;
+    MyVector<T> first(chunkSize), second(chunkSize);
+    MyVector<T> *buffers[BUFFER_COUNT] = {&first, &second};
+    int counts[BUFFER_COUNT] = {};
+    bool full[BUFFER_COUNT] = {};
+
+    // два буфера записи: пока приёмник в своём потоке получает один, обработка продолжается
+    MyVector<T> firstOutput(chunkSize), secondOutput(chunkSize);
+    MyVector<T> *outputs[BUFFER_COUNT] = {&firstOutput, &secondOutput};
+    int outputCounts[BUFFER_COUNT] = {};
+    bool outputFull[BUFFER_COUNT] = {};
+
+    std::mutex mutex;
+    std::condition_variable changed;
+    bool stopped = false;
+    bool cancelled = false;
+    bool writerFailed = false;
+    std::exception_ptr readerError;
+    std::exception_ptr writerError;
+
+    std::thread reader([&]() {
+        try {
+            for(int slot = 0; ; slot = (slot + 1) % BUFFER_COUNT) {
+                {
+                    std::unique_lock<std::mutex> lock(mutex);
+                    changed.wait(lock, [&]() { return !full[slot] || stopped; });
+                    if (stopped)
+                        return;
+                }
+
+                auto start = std::chrono::steady_clock::now();
+                int count = source(*buffers[slot]);
+                if (count < 0 || count > chunkSize)
+                    throw VectorException("Source returned invalid chunk length");
+                account(stats.front(), count, start);
+
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    counts[slot] = count;
+                    full[slot] = true;
+                }
+                changed.notify_all();
+
+                if (count == 0)
+                    return;
+            }
+        } catch(...) {
+            std::lock_guard<std::mutex> lock(mutex);
+            readerError = std::current_exception();
+            counts[0] = counts[1] = 0;
+            full[0] = full[1] = true;
+            changed.notify_all();
+        }
+    });
+
+    // приёмник получает порции в порядке поступления; порция с count == 0 - последняя
+    std::thread writer;
+    if (sink)
+        writer = std::thread([&]() {
+            try {
+                for(int slot = 0; ; slot = (slot + 1) % BUFFER_COUNT) {
+                    int count;
+                    {
+                        std::unique_lock<std::mutex> lock(mutex);
+                        changed.wait(lock, [&]() { return outputFull[slot] || cancelled; });
+                        if (cancelled)
+                            return;
+                        count = outputCounts[slot];
+                    }
+
+                    auto start = std::chrono::steady_clock::now();
+                    sink(*outputs[slot], count);
+                    account(stats.back(), count, start);
+
+                    {
+                        std::lock_guard<std::mutex> lock(mutex);
+                        outputFull[slot] = false;
+                    }
+                    changed.notify_all();
+
+                    if (count == 0)
+                        return;
+                }
+            } catch(...) {
+                std::lock_guard<std::mutex> lock(mutex);
+                writerError = std::current_exception();
+                writerFailed = true;
+                changed.notify_all();
+            }
+        });
+
+    // передать порцию потоку записи, обменяв её с освободившимся буфером записи;
+    // false - приёмник завершился с ошибкой
+    int outputSlot = 0;
+    auto emit = [&](MyVector<T> &chunk, int count) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            changed.wait(lock, [&]() { return !outputFull[outputSlot] || writerFailed; });
+            if (writerFailed)
+                return false;
+        }
+
+        // поток записи не обращается к свободному буферу, а поток чтения - к заполненному
+        std::swap(chunk, *outputs[outputSlot]);
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            outputCounts[outputSlot] = count;
+            outputFull[outputSlot] = true;
+        }
+        changed.notify_all();
+        outputSlot = (outputSlot + 1) % BUFFER_COUNT;
+        return true;
+    };
+
+    std::exception_ptr processError;
+    try {
+        for(int slot = 0; ; slot = (slot + 1) % BUFFER_COUNT) {
+            int count;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                changed.wait(lock, [&]() { return full[slot]; });
+                count = counts[slot];
+            }
+
+            if (count == 0) {
+                if (sink)
+                    emit(*buffers[slot], 0);
+                break;
+            }
+
+            MyVector<T> &chunk = *buffers[slot];
+            for(size_t stage = 0; stage < stages.size(); stage++) {
+                auto start = std::chrono::steady_clock::now();
+                stages[stage](chunk, count);
+                account(stats[stage + 1], count, start);
+            }
+
+            if (sink && !emit(chunk, count))
+                break;
+
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                full[slot] = false;
+            }
+            changed.notify_all();
+        }
+    } catch(...) {
+        processError = std::current_exception();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopped = true;
+        cancelled = processError != nullptr;
+    }
+    changed.notify_all();
+    reader.join();
+    if (writer.joinable())
+        writer.join();
+
+    if (readerError)
+        std::rethrow_exception(readerError);
+    if (processError)
+        std::rethrow_exception(processError);
+    if (writerError)
+        std::rethrow_exception(writerError);
+}
+
+// получить статистику последнего запуска: источник, этапы и приёмник
+template<typename T> const std::vector<typename MyVectorPipeline<T>::StageStats> &MyVectorPipeline<T>::get_stats() const
+{
+    return stats;
+}
+
+// вывести статистику последнего запуска
+template<typename T> void MyVectorPipeline<T>::print_stats(std::ostream &os) const
+{
+    for(const StageStats &stage : stats)
+        os << stage.name << ": " << stage.elements << " elements, " << stage.seconds << " s, "
+           << stage.throughput() << " elements/s" << std::endl;
+}
+
+// источник, читающий элементы из двоичного файла
+template<typename T> typename MyVectorPipeline<T>::Source MyVectorPipeline<T>::file_source(const std::string &path)
+{
+    std::shared_ptr<std::ifstream> stream = std::make_shared<std::ifstream>(path, std::ios::binary);
+    if (!*stream)
+        throw VectorException("Cannot open pipeline input file");
+
+    return [stream](MyVector<T> &buffer) {
+        stream->read(reinterpret_cast<char *>(buffer.data()), (std::streamsize)buffer.get_length() * sizeof(T));
+        return (int)(stream->gcount() / (std::streamsize)sizeof(T));
+    };
+}
+
+// источник, вычисляющий элемент по его номеру; total - общее количество элементов
+template<typename T> typename MyVectorPipeline<T>::Source MyVectorPipeline<T>::generator_source(
+        const std::function<T(long long)> &generator, long long total)
+{
+    std::shared_ptr<long long> position = std::make_shared<long long>(0);
+
+    return [generator, total, position](MyVector<T> &buffer) {
+        int count = (int)std::min<long long>(buffer.get_length(), total - *position);
+        T *data = buffer.data();
+        for(int i = 0; i < count; i++)
+            data[i] = generator(*position + i);
+        *position += count;
+        return count;
+    };
+}
+
+// приёмник, записывающий элементы в двоичный файл
+template<typename T> typename MyVectorPipeline<T>::Sink MyVectorPipeline<T>::file_sink(const std::string &path)
+{
+    std::shared_ptr<std::ofstream> stream = std::make_shared<std::ofstream>(path, std::ios::binary);
+    if (!*stream)
+        throw VectorException("Cannot open pipeline output file");
+
+    return [stream](const MyVector<T> &chunk, int count) {
+        // порции копятся в буфере потока; в конце данных (count == 0) файл сбрасывается на диск,
+        // чтобы он был полностью записан к концу run(), пока приёмник ещё жив
+        if (count == 0)
+            stream->flush();
+        else
+            stream->write(reinterpret_cast<const char *>(chunk.data()), (std::streamsize)count * sizeof(T));
+        if (!*stream)
+            throw VectorException("Cannot write pipeline output file");
+    };
+}
+
+#endif // MyVectorPipeline_H
@@ -0,0 +1,620 @@
+#ifndef MyVectorSketch_H
+#define MyVectorSketch_H
+
+#include <algorithm>
+#include <cmath>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+#include "MyVector.h"
+#include "MyVectorAlgorithms.h"
+#include "VectorException.h"
+
+// Однопроходные сводки распределения значений MyVector с ограниченным расходом памяти:
+// квантильный скетч KLL и гистограммы с равными и логарифмическими корзинами. Все сводки
+// принимают данные пачками прямо из массива вектора и объединяются через merge(), поэтому
+// их можно заполнять в нескольких потоках и сливать в конце (см. build).
+namespace MyVectorSketch {
+
+// Квантильный скетч KLL (Karnin, Lang, Liberty). Значения хранятся в уровнях-компакторах:
+// элемент уровня h представляет 2^h исходных значений. Переполненный уровень сортируется, и
+// каждый второй его элемент (со случайным сдвигом) переходит на уровень выше. Ёмкость уровня
+// убывает в 2/3 раза сверху вниз, поэтому хранится O(k + log n) значений, а ошибка ранга
+// порядка 1 / k. NaN пропускаются.
+template <typename T> class KllSketch {
+private:
+    int k;
+    unsigned long long seed;
+    unsigned long long randomState;
+    long long count;
+    T minimum;
+    T maximum;
+    std::vector<std::vector<T>> levels;
+    int retained;
+    int maxRetained;
+
+    // ёмкость уровня level при текущем количестве уровней
+    int capacity(int level) const
+    {
+        int depth = (int)levels.size() - level - 1;
+        return (int)std::ceil(k * std::pow(2.0 / 3.0, depth)) + 1;
+    }
+
+    // добавить верхний уровень и пересчитать общую ёмкость
+    void grow()
+    {
+        levels.emplace_back();
+        maxRetained = 0;
+        for(int level = 0; level < (int)levels.size(); level++)
+            maxRetained += capacity(level);
+    }
+
+    // случайный бит (splitmix64)
+    bool randomBit()
+    {
+        unsigned long long x = (randomState += 0x9e3779b97f4a7c15ULL);
+        x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+        return ((x ^ (x >> 31)) & 1) != 0;
+    }
+
+    // уплотнять переполненные уровни, пока число хранимых значений не станет меньше ёмкости
+    void compress()
+    {
+        for(int level = 0; level < (int)levels.size() && retained >= maxRetained; level++) {
+            if ((int)levels[level].size() < capacity(level))
+                continue;
+
+            if (level + 1 == (int)levels.size())
+                grow();
+
+            std::vector<T> &current = levels[level];
+            std::vector<T> &next = levels[level + 1];
+            std::sort(current.begin(), current.end());
+
+            // при нечётном размере наименьший элемент остаётся на уровне
+            int keep = (int)current.size() % 2;
+            for(int i = keep + (randomBit() ? 1 : 0); i < (int)current.size(); i += 2)
+                next.push_back(current[i]);
+
+            retained -= (int)current.size() - keep - ((int)current.size() - keep) / 2;
+            current.resize(keep);
+        }
+    }
+
+    // значения всех уровней с весами, упорядоченные по значению
+    std::vector<std::pair<T, long long>> weighted() const
+    {
+        std::vector<std::pair<T, long long>> items;
+        items.reserve(retained);
+        for(int level = 0; level < (int)levels.size(); level++)
+            for(const T &value : levels[level])
+                items.push_back(std::make_pair(value, 1LL << level));
+
+        std::sort(items.begin(), items.end(), [](const std::pair<T, long long> &a, const std::pair<T, long long> &b) {
+            return a.first < b.first;
+        });
+        return items;
+    }
+
+public:
+    // конструктор пустого скетча; большее k точнее, но занимает больше памяти
+    explicit KllSketch(int k = 200, unsigned long long seed = 1) :
+        k(k), seed(seed), randomState(seed), count(0), minimum(), maximum(), retained(0), maxRetained(0)
+    {
+        if (k < 8)
+            throw VectorException("Sketch size must be at least 8");
+
+        grow();
+    }
+
+    // перезапустить генератор случайных сдвигов с начальным значением seed ^ f(salt); копии
+    // одного скетча, заполняемые независимо, должны получить разные salt, иначе их ошибки
+    // уплотнения коррелируют и не компенсируются при объединении
+    void reseed(unsigned long long salt)
+    {
+        randomState = seed ^ (salt * 0x9e3779b97f4a7c15ULL);
+    }
+
+    // удалить все значения, сохранив k и начальное значение генератора
+    void clear()
+    {
+        count = 0;
+        minimum = T();
+        maximum = T();
+        levels.clear();
+        retained = 0;
+        grow();
+    }
+
+    // количество учтённых значений
+    long long get_count() const
+    {
+        return count;
+    }
+
+    // количество хранимых значений
+    int get_retained() const
+    {
+        return retained;
+    }
+
+    // наименьшее значение
+    T get_min() const
+    {
+        if (count == 0)
+            throw VectorException("Sketch is empty");
+
+        return minimum;
+    }
+
+    // наибольшее значение
+    T get_max() const
+    {
+        if (count == 0)
+            throw VectorException("Sketch is empty");
+
+        return maximum;
+    }
+
+    // учесть одно значение
+    void update(const T &value)
+    {
+        update(&value, 1);
+    }
+
+    // учесть length значений из массива
+    void update(const T *values, int length)
+    {
+        while (length > 0) {
+            // пачка не больше свободного места, чтобы память оставалась ограниченной
+            int size = std::min(length, std::max(1, maxRetained - retained));
+            std::vector<T> &bottom = levels[0];
+            int before = (int)bottom.size();
+            if constexpr (std::is_floating_point<T>::value) {
+                for(int i = 0; i < size; i++)
+                    if (values[i] == values[i])
+                        bottom.push_back(values[i]);
+            } else {
+                bottom.insert(bottom.end(), values, values + size);
+            }
+
+            int added = (int)bottom.size() - before;
+            if (added > 0) {
+                const T *begin = bottom.data() + before;
+                T low = begin[0], high = begin[0];
+                for(int i = 1; i < added; i++) {
+                    low = begin[i] < low ? begin[i] : low;
+                    high = high < begin[i] ? begin[i] : high;
+                }
+                minimum = (count == 0 || low < minimum) ? low : minimum;
+                maximum = (count == 0 || maximum < high) ? high : maximum;
+
+                count += added;
+                retained += added;
+                compress();
+            }
+
+            values += size;
+            length -= size;
+        }
+    }
+
+    // учесть все элементы вектора
+    void update(const MyVector<T> &vector)
+    {
+        update(vector.data(), vector.get_length());
+    }
+
+    // добавить значения другого скетча с тем же k
+    void merge(const KllSketch<T> &other)
+    {
+        if (other.k != k)
+            throw VectorException("Sketch parameters do not match");
+
+        if (other.count == 0)
+            return;
+
+        // вставка диапазона вектора в него же - UB, поэтому сам с собой скетч сливается через копию
+        if (&other == this) {
+            KllSketch<T> copy(other);
+            merge(copy);
+            return;
+        }
+
+        while (levels.size() < other.levels.size())
+            grow();
+
+        for(int level = 0; level < (int)other.levels.size(); level++)
+            levels[level].insert(levels[level].end(), other.levels[level].begin(), other.levels[level].end());
+
+        minimum = (count == 0 || other.minimum < minimum) ? other.minimum : minimum;
+        maximum = (count == 0 || maximum < other.maximum) ? other.maximum : maximum;
+        count += other.count;
+        retained += other.retained;
+
+        while (retained >= maxRetained)
+            compress();
+    }
+
+    // доля значений, не превосходящих value
+    double rank(const T &value) const
+    {
+        if (count == 0)
+            throw VectorException("Sketch is empty");
+
+        long long weight = 0;
+        for(int level = 0; level < (int)levels.size(); level++)
+            for(const T &item : levels[level])
+                if (!(value < item))
+                    weight += 1LL << level;
+
+        return (double)weight / count;
+    }
+
+    // приближённый квантиль уровня q из [0, 1]; 0 и 1 дают точные минимум и максимум
+    T quantile(double q) const
+    {
+        if (count == 0)
+            throw VectorException("Sketch is empty");
+
+        if (!(q >= 0 && q <= 1))
+            throw VectorException("Quantile must be in [0, 1]");
+
+        if (q == 0)
+            return minimum;
+        if (q == 1)
+            return maximum;
+
+        std::vector<std::pair<T, long long>> items = weighted();
+        double target = q * count;
+        long long cumulative = 0;
+        for(const std::pair<T, long long> &item : items) {
+            cumulative += item.second;
+            if (cumulative >= target)
+                return item.first;
+        }
+
+        return maximum;
+    }
+};
+
+// Общая часть гистограмм. Корзины 1..bucket_count() лежат между границами, корзина 0
+// считает значения ниже нижней границы, корзина bucket_count() + 1 - не ниже верхней и NaN.
+// Derived реализует void slotsOf(const double *values, double *positions, int *slots, int count) const
+// (номера счётчиков для пачки значений, positions - рабочий буфер), double bucket_lower(int bucket) const и
+// double estimate(int bucket, double fraction) const - значение на доле fraction корзины.
+template <typename Derived, typename T> class MyHistogram {
+protected:
+    int bucketCount;
+    std::vector<long long> counts;
+
+    // размер пачки, для которой номера корзин вычисляются отдельно от увеличения счётчиков
+    static const int BATCH = 256;
+
+    explicit MyHistogram(int bucketCount) : bucketCount(bucketCount), counts(bucketCount + 2, 0) {}
+
+    const Derived &derived() const
+    {
+        return *static_cast<const Derived *>(this);
+    }
+
+    // номера счётчиков по значениям и их дробным позициям среди корзин: ниже lower - счётчик 0,
+    // не ниже upper (выше upper при closedUpper) и NaN - последний. Позиция ограничивается до
+    // приведения к int, чтобы NaN и бесконечности не давали UB. Под AVX2 четыре значения
+    // обрабатываются сравнениями и смешиванием, иначе цикл без ветвлений векторизует компилятор
+    template <bool closedUpper>
+    static void clampSlots(const double *values, const double *positions, int count, int bucketCount,
+                           double lower, double upper, int *slots)
+    {
+        int i = 0;
+#if defined(__AVX2__)
+        const __m256d low = _mm256_set1_pd(lower);
+        const __m256d high = _mm256_set1_pd(upper);
+        const __m256d zero = _mm256_setzero_pd();
+        const __m256d lastPosition = _mm256_set1_pd(bucketCount - 1);
+        const __m256d underflowPosition = _mm256_set1_pd(-1);
+        const __m256d overflowPosition = _mm256_set1_pd(bucketCount);
+        const __m128i one = _mm_set1_epi32(1);
+        for(; i + 4 <= count; i += 4) {
+            __m256d value = _mm256_loadu_pd(values + i);
+            // min и max возвращают второй операнд, если первый NaN
+            __m256d slot = _mm256_max_pd(_mm256_min_pd(_mm256_loadu_pd(positions + i), lastPosition), zero);
+            __m256d below = _mm256_cmp_pd(value, low, _CMP_LT_OQ);
+            __m256d above = closedUpper ? _mm256_cmp_pd(value, high, _CMP_NLE_UQ)
+                                        : _mm256_cmp_pd(value, high, _CMP_NLT_UQ);
+            slot = _mm256_blendv_pd(_mm256_blendv_pd(slot, underflowPosition, below), overflowPosition, above);
+            _mm_storeu_si128((__m128i *)(slots + i), _mm_add_epi32(_mm256_cvttpd_epi32(slot), one));
+        }
+#endif
+        // после выбора нет операций с плавающей точкой, иначе компилятор оставляет их ветвлениями
+        // и цикл не векторизуется; выбор идёт между double, сдвиг на 1 - уже над int
+        const double last = bucketCount - 1;
+        const double overflow = bucketCount;
+        for(; i < count; i++) {
+            double position = std::max(0.0, std::min(positions[i], last));
+            bool below = values[i] < lower;
+            bool above = closedUpper ? !(values[i] <= upper) : !(values[i] < upper);
+            slots[i] = (int)(above ? overflow : below ? -1.0 : position) + 1;
+        }
+    }
+
+public:
+    // получить количество корзин между границами
+    int get_bucket_count() const
+    {
+        return bucketCount;
+    }
+
+    // количество значений в корзине bucket из [0, get_bucket_count())
+    long long get_bucket(int bucket) const
+    {
+        if (bucket < 0 || bucket >= bucketCount)
+            throw VectorException("Index out of range");
+
+        return counts[bucket + 1];
+    }
+
+    // количество значений ниже нижней границы
+    long long get_underflow() const
+    {
+        return counts.front();
+    }
+
+    // количество значений не ниже верхней границы и NaN
+    long long get_overflow() const
+    {
+        return counts.back();
+    }
+
+    // обнулить все счётчики, сохранив границы корзин
+    void clear()
+    {
+        std::fill(counts.begin(), counts.end(), 0);
+    }
+
+    // общее количество учтённых значений
+    long long get_count() const
+    {
+        long long total = 0;
+        for(long long value : counts)
+            total += value;
+
+        return total;
+    }
+
+    // учесть одно значение
+    void update(const T &value)
+    {
+        update(&value, 1);
+    }
+
+    // учесть count значений из массива
+    void update(const T *values, int count)
+    {
+        double points[BATCH];
+        double positions[BATCH];
+        int slots[BATCH];
+        for(int begin = 0; begin < count; begin += BATCH) {
+            int size = std::min(BATCH, count - begin);
+            for(int i = 0; i < size; i++)
+                points[i] = (double)values[begin + i];
+            derived().slotsOf(points, positions, slots, size);
+            for(int i = 0; i < size; i++)
+                counts[slots[i]]++;
+        }
+    }
+
+    // учесть все элементы вектора
+    void update(const MyVector<T> &vector)
+    {
+        update(vector.data(), vector.get_length());
+    }
+
+    // добавить значения гистограммы с теми же границами
+    void merge(const Derived &other)
+    {
+        if (!derived().same_layout(other))
+            throw VectorException("Histogram parameters do not match");
+
+        for(int i = 0; i < (int)counts.size(); i++)
+            counts[i] += other.counts[i];
+    }
+
+    // приближённый квантиль уровня q из [0, 1]; значения за границами оцениваются границей
+    double quantile(double q) const
+    {
+        long long total = get_count();
+        if (total == 0)
+            throw VectorException("Sketch is empty");
+
+        if (!(q >= 0 && q <= 1))
+            throw VectorException("Quantile must be in [0, 1]");
+
+        double target = q * total;
+        long long cumulative = 0;
+        for(int slot = 0; slot < (int)counts.size(); slot++) {
+            if (counts[slot] == 0 || cumulative + counts[slot] < target) {
+                cumulative += counts[slot];
+                continue;
+            }
+
+            if (slot == 0)
+                return derived().bucket_lower(0);
+            if (slot == bucketCount + 1)
+                return derived().bucket_lower(bucketCount);
+
+            return derived().estimate(slot - 1, (target - cumulative) / counts[slot]);
+        }
+
+        return derived().bucket_lower(bucketCount);
+    }
+};
+
+// определение нужно, когда BATCH передаётся по ссылке (std::min) без оптимизации
+template<typename Derived, typename T> const int MyHistogram<Derived, T>::BATCH;
+
+// гистограмма с bucketCount равными корзинами на [low, high)
+template <typename T> class Histogram : public MyHistogram<Histogram<T>, T> {
+    friend class MyHistogram<Histogram<T>, T>;
+
+private:
+    double low;
+    double high;
+    double scale;
+
+    void slotsOf(const double *values, double *positions, int *slots, int count) const
+    {
+        for(int i = 0; i < count; i++)
+            positions[i] = (values[i] - low) * scale;
+
+        this->template clampSlots<false>(values, positions, count, this->bucketCount, low, high, slots);
+    }
+
+    double estimate(int bucket, double fraction) const
+    {
+        return bucket_lower(bucket) + fraction / scale;
+    }
+
+    bool same_layout(const Histogram<T> &other) const
+    {
+        return low == other.low && high == other.high && this->bucketCount == other.bucketCount;
+    }
+
+public:
+    Histogram(const T &low, const T &high, int bucketCount) :
+        MyHistogram<Histogram<T>, T>(bucketCount > 0 ? bucketCount : 1), low((double)low), high((double)high),
+        scale(bucketCount / ((double)high - (double)low))
+    {
+        if (bucketCount <= 0)
+            throw VectorException("Bucket count must be greater than zero");
+
+        if (!(low < high))
+            throw VectorException("Lower bound must be less than upper bound");
+    }
+
+    // нижняя граница корзины bucket; bucket_lower(get_bucket_count()) - верхняя граница
+    double bucket_lower(int bucket) const
+    {
+        return bucket == this->bucketCount ? high : low + bucket / scale;
+    }
+};
+
+// Гистограмма с логарифмическими корзинами на [minValue, maxValue]: границы соседних корзин
+// отличаются в gamma = (1 + e) / (1 - e) раз, поэтому середина корзины оценивает любое её
+// значение с относительной ошибкой не больше e. Значения меньше minValue (в том числе ноль и
+// отрицательные) попадают в нижний счётчик.
+template <typename T> class LogHistogram : public MyHistogram<LogHistogram<T>, T> {
+    friend class MyHistogram<LogHistogram<T>, T>;
+
+private:
+    double minValue;
+    double maxValue;
+    double gamma;
+    double inverseLogGamma;
+
+    static int bucketsFor(double minValue, double maxValue, double relativeError)
+    {
+        if (!(minValue > 0 && minValue < maxValue))
+            throw VectorException("Bounds must satisfy 0 < min < max");
+
+        if (!(relativeError > 0 && relativeError < 1))
+            throw VectorException("Relative error must be in (0, 1)");
+
+        double buckets = std::ceil(std::log(maxValue / minValue) /
+                                   std::log((1 + relativeError) / (1 - relativeError)));
+        if (buckets > (1 << 24))
+            throw VectorException("Too many buckets");
+
+        return std::max(1, (int)buckets);
+    }
+
+    // логарифм считается скалярно через libm, векторно - только выбор счётчика
+    void slotsOf(const double *values, double *positions, int *slots, int count) const
+    {
+        for(int i = 0; i < count; i++)
+            positions[i] = std::log(values[i] / minValue) * inverseLogGamma;
+
+        this->template clampSlots<true>(values, positions, count, this->bucketCount, minValue, maxValue, slots);
+    }
+
+    double estimate(int bucket, double) const
+    {
+        return 2 * bucket_lower(bucket) * gamma / (gamma + 1);
+    }
+
+    bool same_layout(const LogHistogram<T> &other) const
+    {
+        return minValue == other.minValue && maxValue == other.maxValue && gamma == other.gamma;
+    }
+
+public:
+    LogHistogram(double minValue, double maxValue, double relativeError = 0.01) :
+        MyHistogram<LogHistogram<T>, T>(bucketsFor(minValue, maxValue, relativeError)),
+        minValue(minValue), maxValue(maxValue), gamma((1 + relativeError) / (1 - relativeError)),
+        inverseLogGamma(1 / std::log(gamma))
+    {
+    }
+
+    // нижняя граница корзины bucket; bucket_lower(get_bucket_count()) - верхняя граница
+    double bucket_lower(int bucket) const
+    {
+        return bucket == this->bucketCount ? maxValue : minValue * std::pow(gamma, bucket);
+    }
+};
+
+namespace detail {
+
+// сводки со случайностью (reseed) получают для каждой части своё начальное значение
+template<typename Sketch> auto reseed(Sketch &sketch, unsigned long long salt, int) -> decltype(sketch.reseed(salt), void())
+{
+    sketch.reseed(salt);
+}
+
+template<typename Sketch> void reseed(Sketch &, unsigned long long, long)
+{
+}
+
+} // namespace detail
+
+// построить сводку по вектору: копия prototype дополняется всеми элементами vector; при
+// многопоточном выполнении каждый поток заполняет свою пустую сводку с параметрами prototype
+// (Sketch::clear), и они объединяются с копией prototype в конце
+template<typename Sketch, typename T> Sketch build(const Sketch &prototype, const MyVector<T> &vector,
+                                                   const MyVectorAlgorithms::AlgorithmSettings &settings =
+                                                       MyVectorAlgorithms::AlgorithmSettings())
+{
+    Sketch result(prototype);
+    int length = vector.get_length();
+    if (!settings.use_parallel(length)) {
+        result.update(vector);
+        return result;
+    }
+
+    int parts = std::max(1, std::min(settings.threadCount, length));
+    // содержимое prototype учитывается только в result, иначе оно вошло бы parts + 1 раз
+    Sketch empty(prototype);
+    empty.clear();
+    std::vector<Sketch> partial(parts, empty);
+    for(int part = 0; part < parts; part++)
+        detail::reseed(partial[part], (unsigned long long)part + 1, 0);
+
+    const T *data = vector.data();
+    MyVectorAlgorithms::detail::runParallel(parts, length, [&](int part, int begin, int end) {
+        partial[part].update(data + begin, end - begin);
+    });
+
+    for(const Sketch &sketch : partial)
+        result.merge(sketch);
+
+    return result;
+}
+
+} // namespace MyVectorSketch
+
+#endif // MyVectorSketch_H
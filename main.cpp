@@ -2,6 +2,25 @@
 #include "TestException.h"
 #include "VectorException.h"
 #include "MyVector.h"
+#include "MyCompressedVector.h"
+#include "MyVectorAlgorithms.h"
+#include "MyConcurrentVector.h"
+#include "MyMatrix.h"
+#include "MyRcuVector.h"
+#include "MyVectorGenerators.h"
+#include "MyVectorPipeline.h"
+#include "MyVectorIndex.h"
+#include "MyVectorSketch.h"
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <limits>
+#include <thread>
+#include <unordered_set>
+#include <utility>
+#include <vector>
 #include <iostream>
 #include <sstream>
 
@@ -120,6 +139,17 @@ void testEqualOperator() {
     if (vector4[0] != 1 || vector4[1] != 2 || vector4[2] != 3)
         fail("invalid value");
 
+    // присваивание перемещением забирает массив источника без копирования
+    MyVector<int> vector5{7, 8};
+    vector5.enable_aggregate_cache(1);
+    MyVector<int> vector6{4, 5, 6, 7};
+    const int *array = vector6.data();
+    vector5 = std::move(vector6);
+    if (vector5.data() != array || vector5.get_length() != 4 || vector5[3] != 7)
+        fail("invalid move assignment");
+    if (!vector5.is_aggregate_cache_enabled() || vector5.sum() != 22)
+        fail("invalid aggregate after move assignment");
+
     testOk();
 }
 
@@ -428,6 +458,1351 @@ void testIterator() {
     testOk();
 }
 
+// сжатый вектор: frame-of-reference, дельта-кодирование и упаковка битов
+void testCompressedVector() {
+    testStart("testCompressedVector");
+
+    MyVector<int> empty{};
+    MyCompressedVector<int> compressedEmpty(empty);
+    if (compressedEmpty.get_length() != 0 || compressedEmpty.decompress().get_length() != 0)
+        fail("invalid length");
+    if (compressedEmpty.iterator_begin() != compressedEmpty.iterator_end())
+        fail("invalid end mark");
+
+    // отсортированные идентификаторы - дельта-кодирование
+    MyVector<int> sorted(1000);
+    for(int i = 0; i < sorted.get_length(); i++)
+        sorted[i] = 1000000 + i * 3 + (i % 2);
+
+    MyCompressedVector<int> compressedSorted(sorted);
+    if (compressedSorted.get_compressed_size() >= (long long)sizeof(int) * sorted.get_length())
+        fail("vector is not compressed");
+    for(int i = 0; i < sorted.get_length(); i++)
+        if (compressedSorted[i] != sorted[i])
+            fail("invalid value");
+
+    // значения небольшого диапазона, включая отрицательные
+    MyVector<int> counters(300);
+    for(int i = 0; i < counters.get_length(); i++)
+        counters[i] = (i * 7) % 13 - 5;
+    counters[299] = -2147483647 - 1;
+    counters[150] = 2147483647;
+
+    MyCompressedVector<int> compressedCounters(counters);
+    MyVector<int> decompressed = compressedCounters.decompress();
+    if (decompressed.get_length() != counters.get_length())
+        fail("invalid length");
+    for(int i = 0; i < counters.get_length(); i++)
+        if (decompressed[i] != counters[i] || compressedCounters.get_elem(i) != counters[i])
+            fail("invalid value");
+
+    int index = 0;
+    for(MyCompressedVector<int>::Iterator it = compressedCounters.iterator_begin(); !it.is_end(); ++it)
+        if (*it != counters[index++])
+            fail("invalid iterator value");
+    if (index != counters.get_length())
+        fail("invalid iterator length");
+
+    try {
+        compressedCounters[300];
+        fail("no exception");
+    } catch(VectorException &e2) { }
+
+    // все ширины битовых полей от 1 до 63, с неполным последним блоком, в обоих кодированиях
+    for(int width = 1; width < 64; width++) {
+        MyVector<long long> offsets(300), steps(300);
+        unsigned long long state = width;
+        unsigned long long running = 0;
+        for(int i = 0; i < offsets.get_length(); i++) {
+            state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+            unsigned long long field = (state >> 1) >> (63 - width);
+            offsets[i] = (long long)field;
+            running += field >> 1;
+            steps[i] = (long long)running;
+        }
+        offsets[0] = 0;
+        offsets[1] = (long long)((1ULL << width) - 1);
+
+        MyVector<long long> unpackedOffsets = MyCompressedVector<long long>(offsets).decompress();
+        MyVector<long long> unpackedSteps = MyCompressedVector<long long>(steps).decompress();
+        for(int i = 0; i < offsets.get_length(); i++)
+            if (unpackedOffsets[i] != offsets[i] || unpackedSteps[i] != steps[i])
+                fail("invalid value for bit width");
+    }
+
+    testOk();
+}
+
+// сортировка: поразрядная для чисел, слиянием для остальных типов
+void testSortAlgorithm() {
+    testStart("testSortAlgorithm");
+
+    MyVectorAlgorithms::AlgorithmSettings parallel(4, 0);
+
+    MyVector<int> ints(1000);
+    for(int i = 0; i < ints.get_length(); i++)
+        ints[i] = (i * 7919) % 1000 - 500;
+    MyVector<int> intsCopy(ints);
+
+    MyVectorAlgorithms::sort_serial(ints);
+    MyVectorAlgorithms::sort(intsCopy, parallel);
+    for(int i = 0; i < ints.get_length(); i++)
+        if (ints[i] != i - 500 || intsCopy[i] != i - 500)
+            fail("invalid int order");
+
+    MyVector<double> doubles{3.5, -1.25, 0.0, -7.0, 2.0, -0.5};
+    MyVectorAlgorithms::sort(doubles, parallel);
+    for(int i = 1; i < doubles.get_length(); i++)
+        if (doubles[i] < doubles[i - 1])
+            fail("invalid double order");
+    if (doubles[0] != -7.0 || doubles[5] != 3.5)
+        fail("invalid double value");
+
+    MyVector<std::string> strings{"pear", "apple", "plum", "fig", "kiwi"};
+    MyVector<std::string> stringsCopy(strings);
+    MyVectorAlgorithms::sort_serial(strings);
+    MyVectorAlgorithms::sort_parallel(stringsCopy, parallel);
+    if (strings[0] != "apple" || strings[4] != "plum")
+        fail("invalid string order");
+    for(int i = 0; i < strings.get_length(); i++)
+        if (strings[i] != stringsCopy[i])
+            fail("serial and parallel sort differs");
+
+    testOk();
+}
+
+// включающая и исключающая префиксные суммы
+void testScanAlgorithm() {
+    testStart("testScanAlgorithm");
+
+    MyVectorAlgorithms::AlgorithmSettings parallel(3, 0);
+
+    MyVector<int> vector1(100), vector2(100), vector3(100);
+    for(int i = 0; i < 100; i++)
+        vector1[i] = vector2[i] = vector3[i] = i + 1;
+
+    MyVectorAlgorithms::inclusive_scan_serial(vector1);
+    MyVectorAlgorithms::inclusive_scan(vector2, parallel);
+    MyVectorAlgorithms::exclusive_scan(vector3, 10, parallel);
+    for(int i = 0; i < 100; i++) {
+        if (vector1[i] != (i + 1) * (i + 2) / 2 || vector2[i] != vector1[i])
+            fail("invalid inclusive scan");
+        if (vector3[i] != 10 + i * (i + 1) / 2)
+            fail("invalid exclusive scan");
+    }
+
+    testOk();
+}
+
+// стабильное разбиение по предикату
+void testStablePartitionAlgorithm() {
+    testStart("testStablePartitionAlgorithm");
+
+    MyVector<int> vector1{5, 2, 8, 1, 4, 7, 6, 3};
+    MyVector<int> vector2(vector1);
+    auto isEven = [](int value) { return value % 2 == 0; };
+
+    int serialCount = MyVectorAlgorithms::stable_partition_serial(vector1, isEven);
+    int parallelCount = MyVectorAlgorithms::stable_partition(vector2, isEven, MyVectorAlgorithms::AlgorithmSettings(3, 0));
+    if (serialCount != 4 || parallelCount != 4)
+        fail("invalid partition point");
+
+    MyVector<int> expected{2, 8, 4, 6, 5, 1, 7, 3};
+    for(int i = 0; i < expected.get_length(); i++)
+        if (vector1[i] != expected[i] || vector2[i] != expected[i])
+            fail("invalid order");
+
+    testOk();
+}
+
+// удаление подряд идущих повторов
+void testUniqueAlgorithm() {
+    testStart("testUniqueAlgorithm");
+
+    MyVector<int> vector{1, 1, 2, 2, 2, 3, 1, 1, 4};
+    MyVector<int> serial = MyVectorAlgorithms::unique_serial(vector);
+    MyVector<int> parallel = MyVectorAlgorithms::unique(vector, MyVectorAlgorithms::AlgorithmSettings(4, 0));
+
+    MyVector<int> expected{1, 2, 3, 1, 4};
+    if (serial.get_length() != expected.get_length() || parallel.get_length() != expected.get_length())
+        fail("invalid length");
+    for(int i = 0; i < expected.get_length(); i++)
+        if (serial[i] != expected[i] || parallel[i] != expected[i])
+            fail("invalid value");
+
+    if (MyVectorAlgorithms::unique(MyVector<int>{}).get_length() != 0)
+        fail("invalid empty length");
+
+    testOk();
+}
+
+// двоичный поиск в отсортированном векторе
+void testLowerBoundAlgorithm() {
+    testStart("testLowerBoundAlgorithm");
+
+    MyVector<int> sorted{1, 3, 3, 5, 9};
+    if (MyVectorAlgorithms::lower_bound(sorted, 0) != 0 || MyVectorAlgorithms::lower_bound(sorted, 3) != 1 ||
+        MyVectorAlgorithms::lower_bound(sorted, 4) != 3 || MyVectorAlgorithms::lower_bound(sorted, 10) != 5)
+        fail("invalid position");
+
+    MyVector<int> values{10, 3, 0, 6};
+    MyVector<int> positions = MyVectorAlgorithms::lower_bound(sorted, values, MyVectorAlgorithms::AlgorithmSettings(2, 0));
+    if (positions[0] != 5 || positions[1] != 1 || positions[2] != 0 || positions[3] != 4)
+        fail("invalid batch position");
+
+    testOk();
+}
+
+// одновременное добавление элементов из нескольких потоков
+void testConcurrentVector() {
+    testStart("testConcurrentVector");
+
+    const int producers = 4;
+    const int perProducer = 5000;
+
+    MyConcurrentVector<int> vector;
+    std::thread threads[producers];
+    for(int t = 0; t < producers; t++)
+        threads[t] = std::thread([&vector, t]() {
+            for(int i = 0; i < perProducer; i++)
+                vector.push_back(i * producers + t);
+            vector.append(MyVector<int>{-1, -1, -1});
+        });
+    for(int t = 0; t < producers; t++)
+        threads[t].join();
+
+    MyVector<int> compacted = vector.compact();
+    if (compacted.get_length() != producers * (perProducer + 3))
+        fail("invalid length");
+
+    MyVector<int> seen(producers * perProducer);
+    int markers = 0;
+    for(int i = 0; i < compacted.get_length(); i++) {
+        if (compacted[i] == -1)
+            markers++;
+        else
+            seen[compacted[i]]++;
+    }
+    if (markers != producers * 3)
+        fail("invalid appended values");
+    for(int i = 0; i < seen.get_length(); i++)
+        if (seen[i] != 1)
+            fail("element lost or duplicated");
+
+    if (vector[5] != compacted[5])
+        fail("invalid value");
+
+    try {
+        vector[compacted.get_length()];
+        fail("no exception");
+    } catch(VectorException &e2) { }
+
+    testOk();
+}
+
+// матрица: доступ к элементам, строки, столбцы и транспонирование
+void testMatrix() {
+    testStart("testMatrix");
+
+    MyMatrix<int> rowMajor(2, 3);
+    MyMatrix<int> columnMajor(2, 3, MyMatrix<int>::COLUMN_MAJOR);
+    for(int row = 0; row < 2; row++)
+        for(int column = 0; column < 3; column++) {
+            rowMajor(row, column) = row * 3 + column;
+            columnMajor.set_elem(row, column, row * 3 + column);
+        }
+
+    if (rowMajor.data()[1] != 1 || columnMajor.data()[1] != 3)
+        fail("invalid layout");
+
+    MyVector<int> row = columnMajor.get_row(1);
+    MyVector<int> column = rowMajor.get_column(2);
+    if (row.get_length() != 3 || row[0] != 3 || row[2] != 5)
+        fail("invalid row");
+    if (column.get_length() != 2 || column[0] != 2 || column[1] != 5)
+        fail("invalid column");
+
+    rowMajor.set_column(0, MyVector<int>{7, 8});
+    if (rowMajor(0, 0) != 7 || rowMajor(1, 0) != 8)
+        fail("invalid set column");
+
+    MyMatrix<int> transposed = columnMajor.transpose();
+    if (transposed.get_rows() != 3 || transposed.get_columns() != 2 ||
+        transposed.get_layout() != MyMatrix<int>::COLUMN_MAJOR)
+        fail("invalid transposed size");
+    for(int r = 0; r < 2; r++)
+        for(int c = 0; c < 3; c++)
+            if (transposed(c, r) != columnMajor(r, c))
+                fail("invalid transposed value");
+
+    try {
+        rowMajor(2, 0);
+        fail("no exception");
+    } catch(VectorException &e2) { }
+
+    testOk();
+}
+
+// произведение матрицы на вектор и матриц
+void testMatrixMultiply() {
+    testStart("testMatrixMultiply");
+
+    const int n = 70, k = 300, m = 45;
+    MyMatrix<long long> a(n, k), b(k, m, MyMatrix<long long>::COLUMN_MAJOR);
+    for(int i = 0; i < n; i++)
+        for(int j = 0; j < k; j++)
+            a(i, j) = (i * 31 + j * 17) % 11 - 5;
+    for(int i = 0; i < k; i++)
+        for(int j = 0; j < m; j++)
+            b(i, j) = (i * 13 + j * 7) % 9 - 4;
+
+    MyMatrix<long long> c = a.multiply(b, 3);
+    MyMatrix<long long> cColumns = b.transpose().multiply(a.transpose());
+    for(int i = 0; i < n; i++)
+        for(int j = 0; j < m; j++) {
+            long long expected = 0;
+            for(int p = 0; p < k; p++)
+                expected += a(i, p) * b(p, j);
+            if (c(i, j) != expected || cColumns(j, i) != expected)
+                fail("invalid matrix product");
+        }
+
+    MyVector<long long> x(k);
+    for(int i = 0; i < k; i++)
+        x[i] = i % 5 - 2;
+    MyVector<long long> y = a * x;
+    MyVector<long long> yColumns = a.to_layout(MyMatrix<long long>::COLUMN_MAJOR).multiply(x, 4);
+    for(int i = 0; i < n; i++) {
+        long long expected = 0;
+        for(int p = 0; p < k; p++)
+            expected += a(i, p) * x[p];
+        if (y[i] != expected || yColumns[i] != expected)
+            fail("invalid matrix-vector product");
+    }
+
+    try {
+        a * a;
+        fail("no exception");
+    } catch(VectorException &e2) { }
+
+    testOk();
+}
+
+// this = a * x + this
+void testAxpyOperation() {
+    testStart("testAxpyOperation");
+
+    MyVector<double> y{1.0, 2.0, 3.0};
+    MyVector<double> x{0.5, -1.0, 2.0};
+    y.axpy(2.0, x);
+    if (y[0] != 2.0 || y[1] != 0.0 || y[2] != 7.0)
+        fail("invalid value");
+    if (x[0] != 0.5 || x[1] != -1.0 || x[2] != 2.0)
+        fail("operand changed");
+
+    try {
+        y.axpy(1.0, MyVector<double>{1.0});
+        fail("no exception");
+    } catch(VectorException &e2) { }
+
+    testOk();
+}
+
+// this = a * x + b * this
+void testAxpbyOperation() {
+    testStart("testAxpbyOperation");
+
+    MyVector<int> y{1, 2, 3};
+    y.axpby(3, MyVector<int>{1, 1, 1}, -2);
+    if (y[0] != 1 || y[1] != -1 || y[2] != -3)
+        fail("invalid value");
+
+    testOk();
+}
+
+// поэлементное умножение и деление
+void testHadamardOperation() {
+    testStart("testHadamardOperation");
+
+    MyVector<int> vector{2, 4, 6};
+    vector.hadamard(MyVector<int>{3, -1, 2});
+    if (vector[0] != 6 || vector[1] != -4 || vector[2] != 12)
+        fail("invalid product");
+
+    vector.hadamard_divide(MyVector<int>{2, 4, 3});
+    if (vector[0] != 3 || vector[1] != -1 || vector[2] != 4)
+        fail("invalid quotient");
+
+    try {
+        vector.hadamard_divide(MyVector<int>{1, 0, 1});
+        fail("no exception");
+    } catch(VectorException &e2) { }
+    if (vector[0] != 3 || vector[1] != -1 || vector[2] != 4)
+        fail("vector changed after exception");
+
+    testOk();
+}
+
+// this = a * b + c поэлементно
+void testFmaOperation() {
+    testStart("testFmaOperation");
+
+    MyVector<float> a{1.0f, 2.0f, 3.0f};
+    MyVector<float> b{4.0f, 5.0f, 6.0f};
+    MyVector<float> c{0.5f, 0.5f, 0.5f};
+    MyVector<float> result(3);
+    result.fma(a, b, c);
+    if (result[0] != 4.5f || result[1] != 10.5f || result[2] != 18.5f)
+        fail("invalid value");
+
+    // результат может совпадать с одним из аргументов
+    c.fma(a, b, c);
+    if (c[0] != 4.5f || c[2] != 18.5f)
+        fail("invalid aliased value");
+
+    testOk();
+}
+
+// ограничение элементов отрезком
+void testClampOperation() {
+    testStart("testClampOperation");
+
+    MyVector<int> vector{-5, 0, 3, 10};
+    vector.clamp(-1, 5);
+    if (vector[0] != -1 || vector[1] != 0 || vector[2] != 3 || vector[3] != 5)
+        fail("invalid value");
+
+    try {
+        vector.clamp(5, -1);
+        fail("no exception");
+    } catch(VectorException &e2) { }
+
+    testOk();
+}
+
+// модуль каждого элемента
+void testAbsOperation() {
+    testStart("testAbsOperation");
+
+    MyVector<int> ints{-3, 0, 4};
+    ints.abs();
+    if (ints[0] != 3 || ints[1] != 0 || ints[2] != 4)
+        fail("invalid int value");
+
+    // модуль наименьшего значения не представим и насыщается до наибольшего
+    MyVector<int> extremes{std::numeric_limits<int>::min(), std::numeric_limits<int>::max(), -1};
+    extremes.abs();
+    if (extremes[0] != std::numeric_limits<int>::max() || extremes[1] != std::numeric_limits<int>::max() ||
+        extremes[2] != 1)
+        fail("invalid int minimum value");
+    MyVector<long> longs{std::numeric_limits<long>::min()};
+    if (longs.abs()[0] != std::numeric_limits<long>::max())
+        fail("invalid long minimum value");
+
+    MyVector<double> doubles{-1.5, 2.5};
+    doubles.abs();
+    if (doubles[0] != 1.5 || doubles[1] != 2.5)
+        fail("invalid double value");
+
+    testOk();
+}
+
+// сбор элементов по списку индексов
+void testGather() {
+    testStart("testGather");
+
+    MyVector<int> ints(100);
+    MyVector<double> doubles(100);
+    for(int i = 0; i < 100; i++) {
+        ints[i] = i * 10;
+        doubles[i] = i * 0.5;
+    }
+
+    MyVector<int> indices(37);
+    for(int i = 0; i < indices.get_length(); i++)
+        indices[i] = (i * 53) % 100;
+
+    MyVector<int> gatheredInts(37);
+    MyVector<double> gatheredDoubles(37);
+    ints.gather(indices, gatheredInts);
+    doubles.gather(indices, gatheredDoubles);
+    for(int i = 0; i < indices.get_length(); i++)
+        if (gatheredInts[i] != indices[i] * 10 || gatheredDoubles[i] != indices[i] * 0.5)
+            fail("invalid value");
+
+    try {
+        ints.gather(MyVector<int>{1, 100}, gatheredInts);
+        fail("no exception");
+    } catch(VectorException &e2) { }
+
+    MyVector<int> out(2);
+    try {
+        ints.gather(MyVector<int>{1, -1}, out);
+        fail("no exception");
+    } catch(VectorException &e2) { }
+
+    testOk();
+}
+
+// запись элементов по списку индексов
+void testScatter() {
+    testStart("testScatter");
+
+    MyVector<int> vector(10);
+    vector.scatter(MyVector<int>{9, 0, 4, 4}, MyVector<int>{1, 2, 3, 5});
+    if (vector[9] != 1 || vector[0] != 2 || vector[4] != 5 || vector[1] != 0)
+        fail("invalid value");
+
+    try {
+        vector.scatter(MyVector<int>{10}, MyVector<int>{1});
+        fail("no exception");
+    } catch(VectorException &e2) { }
+    try {
+        vector.scatter(MyVector<int>{1, 2}, MyVector<int>{1});
+        fail("no exception");
+    } catch(VectorException &e2) { }
+
+    testOk();
+}
+
+// агрегаты с кэшированием по блокам и отслеживанием изменений
+void testAggregateCache() {
+    testStart("testAggregateCache");
+
+    MyVector<int> plain{3, -1, 4, 1, -5, 9};
+    if (plain.sum() != 11 || plain.min_elem() != -5 || plain.max_elem() != 9)
+        fail("invalid uncached aggregate");
+
+    const int length = 1000;
+    MyVector<long> cached(length);
+    MyVector<long> reference(length);
+    for(int i = 0; i < length; i++)
+        cached[i] = reference[i] = (i * 37) % 101 - 50;
+
+    cached.enable_aggregate_cache(16);
+    if (!cached.is_aggregate_cache_enabled())
+        fail("cache is not enabled");
+
+    auto check = [&]() {
+        if (cached.sum() != reference.sum() || cached.min_elem() != reference.min_elem() ||
+            cached.max_elem() != reference.max_elem() || cached.norm() != reference.norm())
+            fail("invalid cached aggregate");
+    };
+    check();
+
+    // запись через set_elem, get_elem и operator []
+    cached.set_elem(5, 1000);
+    reference.set_elem(5, 1000);
+    check();
+    cached[999] = -1000;
+    reference[999] = -1000;
+    cached.get_elem(500) += 7;
+    reference.get_elem(500) += 7;
+    check();
+
+    // изменение всех элементов и длины вектора
+    cached *= 2;
+    reference *= 2;
+    check();
+    cached.scatter(MyVector<int>{0, 17, 300}, MyVector<long>{-3000, 2, 3});
+    reference.scatter(MyVector<int>{0, 17, 300}, MyVector<long>{-3000, 2, 3});
+    check();
+    if ((cached += MyVector<long>{5000}).get_length() != length + 1)
+        fail("+= does not return this");
+    reference += MyVector<long>{5000};
+    check();
+
+    // константный доступ не сбрасывает кэш и видит актуальные значения
+    const MyVector<long> &view = cached;
+    if (view[length] != 5000 || view.get_elem(5) != reference[5])
+        fail("invalid const access");
+    check();
+
+    // одновременные константные запросы из нескольких потоков
+    cached.set_elem(1, 12345);
+    reference.set_elem(1, 12345);
+    long expected = reference.sum();
+    std::vector<std::thread> readers;
+    std::atomic<bool> mismatch(false);
+    for(int i = 0; i < 4; i++)
+        readers.emplace_back([&]() {
+            if (view.sum() != expected || view.max_elem() != reference.max_elem())
+                mismatch = true;
+        });
+    for(std::thread &reader : readers)
+        reader.join();
+    if (mismatch)
+        fail("invalid concurrent aggregate");
+    cached.axpy(3, reference);
+    reference.axpy(3, reference);
+    check();
+
+    cached.disable_aggregate_cache();
+    if (cached.is_aggregate_cache_enabled() || cached.sum() != reference.sum())
+        fail("invalid disabled cache");
+
+    MyVector<int> empty{};
+    empty.enable_aggregate_cache();
+    if (empty.sum() != 0 || empty.norm() != 0)
+        fail("invalid empty aggregate");
+    try {
+        empty.min_elem();
+        fail("no exception");
+    } catch(VectorException &e2) { }
+
+    testOk();
+}
+
+// публикация версий и согласованные снимки для читателей
+void testRcuVector() {
+    testStart("testRcuVector");
+
+    MyRcuVector<int> vector(MyVector<int>{1, 2, 3, 4, 5}, 2);
+    MyRcuVector<int>::Reader reader(vector);
+
+    {
+        MyRcuVector<int>::Snapshot before = reader.snapshot();
+
+        vector.set_elem(4, 50);
+        if (vector.get_elem(4) != 50 || before[4] != 5)
+            fail("draft is visible before publish");
+
+        vector.publish();
+        if (before.get_length() != 5 || before[4] != 5)
+            fail("snapshot changed after publish");
+
+        // пока старый снимок жив, его версия не освобождается
+        if (vector.get_retired_count() != 1)
+            fail("version reclaimed too early");
+
+        try {
+            reader.snapshot();
+            fail("no exception");
+        } catch(VectorException &e2) { }
+    }
+
+    MyRcuVector<int>::Snapshot after = reader.snapshot();
+    MyVector<int> copy = after.to_vector();
+    if (copy.get_length() != 5 || copy[0] != 1 || copy[4] != 50)
+        fail("invalid published value");
+
+    vector.reclaim();
+    if (vector.get_retired_count() != 0)
+        fail("version is not reclaimed");
+
+    try {
+        after[5];
+        fail("no exception");
+    } catch(VectorException &e2) { }
+
+    testOk();
+}
+
+// снимок, переживший свой Reader, продолжает защищать версию и занимать слот
+void testRcuSnapshotOutlivesReader() {
+    testStart("testRcuSnapshotOutlivesReader");
+
+    MyRcuVector<int> vector(MyVector<int>{1, 2, 3}, 1);
+    MyRcuVector<int>::Reader *first = new MyRcuVector<int>::Reader(vector);
+    MyRcuVector<int>::Snapshot orphan = first->snapshot();
+    delete first;
+
+    // все остальные слоты можно занять, слот снимка - нет
+    std::vector<MyRcuVector<int>::Reader *> readers;
+    try {
+        while (true)
+            readers.push_back(new MyRcuVector<int>::Reader(vector));
+    } catch(VectorException &e2) { }
+    if ((int)readers.size() != MyRcuVector<int>::MAX_READERS - 1)
+        fail("orphaned slot was reused");
+
+    // новые читатели не сбрасывают эпоху снимка, его версия не освобождается
+    for(MyRcuVector<int>::Reader *reader : readers) {
+        MyRcuVector<int>::Snapshot snapshot = reader->snapshot();
+    }
+    vector.set_elem(0, 10);
+    vector.publish();
+    vector.reclaim();
+    if (vector.get_retired_count() != 1 || orphan[0] != 1)
+        fail("version reclaimed under live snapshot");
+
+    for(MyRcuVector<int>::Reader *reader : readers)
+        delete reader;
+    {
+        MyRcuVector<int>::Snapshot released = std::move(orphan);
+    }
+
+    vector.reclaim();
+    if (vector.get_retired_count() != 0)
+        fail("version is not reclaimed");
+    MyRcuVector<int>::Reader reader(vector);
+
+    testOk();
+}
+
+// снимки из нескольких потоков во время записи
+void testRcuVectorConcurrentReaders() {
+    testStart("testRcuVectorConcurrentReaders");
+
+    const int length = 256;
+    const int versions = 200;
+    MyRcuVector<int> vector(MyVector<int>(length), 16);
+    std::atomic<bool> done(false);
+    std::atomic<int> inconsistent(0);
+
+    std::thread readers[4];
+    for(int t = 0; t < 4; t++)
+        readers[t] = std::thread([&]() {
+            MyRcuVector<int>::Reader reader(vector);
+            while (!done.load()) {
+                MyRcuVector<int>::Snapshot snapshot = reader.snapshot();
+                int first = snapshot[0];
+                for(int i = 1; i < snapshot.get_length(); i++)
+                    if (snapshot[i] != first)
+                        inconsistent++;
+            }
+        });
+
+    MyVector<int> next(length);
+    for(int version = 1; version <= versions; version++) {
+        if (version % 2 == 0) {
+            for(int i = 0; i < length; i++)
+                vector.set_elem(i, version);
+            vector.publish();
+        } else {
+            for(int i = 0; i < length; i++)
+                next[i] = version;
+            vector.publish(next);
+        }
+    }
+
+    done.store(true);
+    for(int t = 0; t < 4; t++)
+        readers[t].join();
+
+    if (inconsistent.load() != 0)
+        fail("inconsistent snapshot");
+
+    vector.reclaim();
+    if (vector.get_retired_count() != 0 || vector.get_elem(length - 1) != versions)
+        fail("invalid final state");
+
+    testOk();
+}
+
+// ленивые векторы: константа, прогрессия, сетка и псевдослучайный вектор
+void testGenerators() {
+    testStart("testGenerators");
+
+    MyVector<int> constant = MyVectorGenerators::constant(3, 7).materialize();
+    if (constant.get_length() != 3 || constant[0] != 7 || constant[2] != 7)
+        fail("invalid constant");
+
+    MyVectorGenerators::IotaGenerator<int> iota = MyVectorGenerators::iota(5, 10, -2);
+    if (iota.get_length() != 5 || iota[0] != 10 || iota[4] != 2)
+        fail("invalid iota");
+
+    MyVectorGenerators::LinspaceGenerator<double> linspace = MyVectorGenerators::linspace(5, 0.0, 1.0);
+    if (linspace[0] != 0.0 || linspace[2] != 0.5 || linspace[4] != 1.0)
+        fail("invalid linspace");
+
+    MyVectorGenerators::RandomGenerator<int> random1 = MyVectorGenerators::random_vector(100, 42, -3, 3);
+    MyVectorGenerators::RandomGenerator<int> random2 = MyVectorGenerators::random_vector(100, 42, -3, 3);
+    MyVectorGenerators::RandomGenerator<double> random3 = MyVectorGenerators::random_vector(100, 7, 1.0, 2.0);
+    bool differs = false;
+    for(int i = 0; i < 100; i++) {
+        if (random1[i] != random2[i])
+            fail("random vector is not reproducible");
+        if (random1[i] < -3 || random1[i] > 3 || random3[i] < 1.0 || random3[i] >= 2.0)
+            fail("random value out of range");
+        differs |= random1[i] != random1[0];
+    }
+    if (!differs)
+        fail("random vector is constant");
+
+    try {
+        iota[5];
+        fail("no exception");
+    } catch(VectorException &e2) { }
+
+    testOk();
+}
+
+// арифметика ленивых векторов с MyVector
+void testGeneratorArithmetic() {
+    testStart("testGeneratorArithmetic");
+
+    MyVector<int> vector{10, 20, 30};
+    vector -= MyVectorGenerators::constant(3, 1);
+    if (vector[0] != 9 || vector[1] != 19 || vector[2] != 29)
+        fail("invalid -= constant");
+
+    MyVector<int> difference = vector - MyVectorGenerators::iota(4, 0, 10);
+    if (difference.get_length() != 4 || difference[0] != 9 || difference[2] != 9 || difference[3] != -30)
+        fail("invalid - iota");
+
+    MyVector<int> reversed = MyVectorGenerators::iota(2, 100, 1) - vector;
+    if (reversed.get_length() != 3 || reversed[0] != 91 || reversed[1] != 82 || reversed[2] != -29)
+        fail("invalid iota -");
+
+    vector -= MyVectorGenerators::constant(4, 9);
+    if (vector.get_length() != 4 || vector[0] != 0 || vector[3] != -9)
+        fail("invalid -= longer generator");
+
+    // конкатенация и поэлементные операции без материализации генератора
+    MyVector<int> joined = vector + MyVectorGenerators::iota(2, 1, 1);
+    MyVector<int> prefixed = MyVectorGenerators::constant(1, 5) + vector;
+    if (joined.get_length() != 6 || joined[3] != -9 || joined[4] != 1 || joined[5] != 2 ||
+        prefixed.get_length() != 5 || prefixed[0] != 5 || prefixed[4] != -9)
+        fail("invalid + generator");
+    joined += MyVectorGenerators::constant(1, 7);
+    if (joined.get_length() != 7 || joined[6] != 7)
+        fail("invalid += generator");
+
+    MyVector<double> y{1, 2, 3};
+    axpy(y, 2.0, MyVectorGenerators::iota(3, 1.0));
+    if (y[0] != 3 || y[1] != 6 || y[2] != 9)
+        fail("invalid axpy generator");
+    axpby(y, 1.0, MyVectorGenerators::constant(3, 1.0), 2.0);
+    hadamard(y, MyVectorGenerators::iota(3, 1.0));
+    if (y[0] != 7 || y[1] != 26 || y[2] != 57)
+        fail("invalid axpby or hadamard generator");
+    hadamard_divide(y, MyVectorGenerators::constant(3, 0.5));
+    if (y[0] != 14 || y[2] != 114)
+        fail("invalid hadamard_divide generator");
+
+    MyVector<int> ints{4, 6};
+    try {
+        hadamard_divide(ints, MyVectorGenerators::iota(2, 0));
+        fail("no exception");
+    } catch(VectorException &e2) { }
+    try {
+        axpy(ints, 1, MyVectorGenerators::constant(3, 1));
+        fail("no exception");
+    } catch(VectorException &e2) { }
+    if (ints[0] != 4 || ints[1] != 6)
+        fail("vector changed by failed operation");
+
+    testOk();
+}
+
+// потоковая обработка данных порциями
+void testPipeline() {
+    testStart("testPipeline");
+
+    const long long total = 10037;
+    const char *path = "testPipeline.bin";
+
+    // первый проход: генератор -> (x * 3 - 1) -> сумма и файл
+    long long sum = 0;
+    MyVectorPipeline<long long> writer(1000);
+    writer.set_source(MyVectorPipeline<long long>::generator_source([](long long i) { return i; }, total))
+          .add_multiply(3)
+          .add_subtract(MyVector<long long>(MyVectorGenerators::constant(1000, 1LL).materialize()))
+          .add_sum(sum)
+          .set_sink(MyVectorPipeline<long long>::file_sink(path));
+    writer.run();
+
+    if (sum != 3 * total * (total - 1) / 2 - total)
+        fail("invalid sum");
+
+    const std::vector<MyVectorPipeline<long long>::StageStats> &stats = writer.get_stats();
+    if (stats.size() != 5 || stats.front().name != "source" || stats.back().name != "sink")
+        fail("invalid stats");
+    for(const MyVectorPipeline<long long>::StageStats &stage : stats)
+        if (stage.elements != total)
+            fail("invalid element count");
+
+    // второй проход: файл -> / 2 -> максимум
+    long long maximum = -1;
+    MyVectorPipeline<long long> reader(512);
+    reader.set_source(MyVectorPipeline<long long>::file_source(path))
+          .add_divide(2)
+          .add_reduction("max", maximum, [](const long long &a, const long long &b) { return a < b ? b : a; });
+    reader.run();
+    std::remove(path);
+
+    if (maximum != (3 * (total - 1) - 1) / 2)
+        fail("invalid reduction");
+
+    MyVectorPipeline<long long> failing(16);
+    failing.set_source([](MyVector<long long> &) -> int { throw VectorException("read error"); });
+    try {
+        failing.run();
+        fail("no exception");
+    } catch(VectorException &e2) { }
+
+    // приёмник в потоке записи получает порции по порядку и ровно один завершающий вызов
+    std::vector<long long> received;
+    int finalCalls = 0;
+    MyVectorPipeline<long long> ordered(7);
+    ordered.set_source(MyVectorPipeline<long long>::generator_source([](long long i) { return i; }, 100))
+           .add_multiply(2)
+           .set_sink([&](const MyVector<long long> &chunk, int count) {
+               finalCalls += count == 0;
+               for(int i = 0; i < count; i++)
+                   received.push_back(chunk[i]);
+           });
+    ordered.run();
+    if (received.size() != 100 || finalCalls != 1)
+        fail("invalid sink calls");
+    for(int i = 0; i < 100; i++)
+        if (received[i] != 2 * i)
+            fail("invalid sink order");
+
+    // ошибки приёмника и этапа передаются из run() без зависания потоков
+    MyVectorPipeline<long long> failingSink(4);
+    failingSink.set_source(MyVectorPipeline<long long>::generator_source([](long long i) { return i; }, 1000))
+               .set_sink([](const MyVector<long long> &, int count) {
+                   if (count > 0)
+                       throw VectorException("write error");
+               });
+    try {
+        failingSink.run();
+        fail("no exception");
+    } catch(VectorException &e2) { }
+
+    MyVectorPipeline<long long> failingStage(4);
+    failingStage.set_source(MyVectorPipeline<long long>::generator_source([](long long i) { return i; }, 1000))
+                .add_stage("fail", [](MyVector<long long> &chunk, int) {
+                    if (chunk[0] > 100)
+                        throw VectorException("stage error");
+                })
+                .set_sink([](const MyVector<long long> &, int) { });
+    try {
+        failingStage.run();
+        fail("no exception");
+    } catch(VectorException &e2) { }
+
+    testOk();
+}
+
+// оставить в файле первые length байт
+void truncateFile(const char *path, std::streamsize length) {
+    std::string content;
+    {
+        std::ifstream input(path, std::ios::binary);
+        content.assign(std::istreambuf_iterator<char>(input), std::istreambuf_iterator<char>());
+    }
+    std::ofstream output(path, std::ios::binary | std::ios::trunc);
+    output.write(content.data(), std::min<std::streamsize>(length, (std::streamsize)content.size()));
+}
+
+// точный поиск ближайших соседей полным перебором
+void testFlatIndex() {
+    testStart("testFlatIndex");
+
+    const int dimension = 37, count = 600;
+    MyMatrix<float> vectors(count, dimension);
+    for(int i = 0; i < count; i++)
+        vectors.set_row(i, MyVectorGenerators::random_vector(dimension, 100 + i, -1.0f, 1.0f).materialize());
+    MyVector<float> query = MyVectorGenerators::random_vector(dimension, 7, -1.0f, 1.0f).materialize();
+
+    const MyVectorIndex::Metric metrics[] = {MyVectorIndex::L2, MyVectorIndex::INNER_PRODUCT, MyVectorIndex::COSINE};
+    for(MyVectorIndex::Metric metric : metrics) {
+        MyVectorIndex::FlatIndex<float> index(dimension, metric);
+        for(int i = 0; i < count / 2; i++)
+            index.add(vectors.get_row(i));
+        MyMatrix<float> rest(count - count / 2, dimension, MyMatrix<float>::COLUMN_MAJOR);
+        for(int i = count / 2; i < count; i++)
+            rest.set_row(i - count / 2, vectors.get_row(i));
+        if (index.add(rest) != count / 2 || index.get_size() != count)
+            fail("invalid index size");
+
+        // наилучший вектор, найденный простым циклом
+        int best = -1;
+        double bestDistance = 0;
+        double queryNorm = query.norm();
+        for(int i = 0; i < count; i++) {
+            double squared = 0, product = 0, norm = 0;
+            for(int j = 0; j < dimension; j++) {
+                double d = vectors(i, j) - query[j];
+                squared += d * d;
+                product += vectors(i, j) * query[j];
+                norm += vectors(i, j) * vectors(i, j);
+            }
+            double distance = metric == MyVectorIndex::L2 ? squared :
+                              metric == MyVectorIndex::INNER_PRODUCT ? -product : 1 - product / (std::sqrt(norm) * queryNorm);
+            if (best < 0 || distance < bestDistance) {
+                best = i;
+                bestDistance = distance;
+            }
+        }
+
+        MyVector<MyVectorIndex::Neighbor<float>> found = index.search(query, 10);
+        MyVector<MyVectorIndex::Neighbor<float>> parallel = index.search(query, 10, 4);
+        if (found.get_length() != 10 || found[0].id != best || std::fabs(found[0].distance - bestDistance) > 1e-4)
+            fail("invalid nearest neighbour");
+        for(int i = 0; i < 10; i++) {
+            if (i > 0 && found[i].distance < found[i - 1].distance)
+                fail("neighbours are not sorted");
+            if (parallel[i].id != found[i].id)
+                fail("invalid parallel search");
+        }
+
+        MyMatrix<float> queries(3, dimension);
+        for(int i = 0; i < 3; i++)
+            queries.set_row(i, i == 1 ? query : vectors.get_row(i * 50));
+        MyVector<MyVectorIndex::Neighbor<float>> batch = index.search(queries, 10, 2);
+        if (batch.get_length() != 30 || batch[10].id != best || (metric == MyVectorIndex::L2 && batch[20].id != 100))
+            fail("invalid batch search");
+    }
+
+    MyVectorIndex::FlatIndex<float> index(dimension, MyVectorIndex::COSINE);
+    index.add(vectors);
+    index.save("testFlatIndex.bin");
+    MyVectorIndex::FlatIndex<float> loaded = MyVectorIndex::FlatIndex<float>::load("testFlatIndex.bin");
+
+    // обрезанный файл отвергается до выделения памяти под векторы
+    truncateFile("testFlatIndex.bin", 64);
+    try {
+        MyVectorIndex::FlatIndex<float>::load("testFlatIndex.bin");
+        fail("no exception");
+    } catch(VectorException &e2) { }
+    std::remove("testFlatIndex.bin");
+    MyVector<MyVectorIndex::Neighbor<float>> expected = index.search(query, 5);
+    MyVector<MyVectorIndex::Neighbor<float>> actual = loaded.search(query, 5);
+    if (loaded.get_size() != count || loaded.get_metric() != MyVectorIndex::COSINE)
+        fail("invalid loaded index");
+    for(int i = 0; i < 5; i++)
+        if (actual[i].id != expected[i].id || actual[i].distance != expected[i].distance)
+            fail("invalid loaded search");
+
+    try {
+        index.search(MyVector<float>(3), 1);
+        fail("no exception");
+    } catch(VectorException &e2) { }
+
+    try {
+        index.search(query, 0);
+        fail("no exception");
+    } catch(VectorException &e2) { }
+
+    testOk();
+}
+
+// приближённый поиск ближайших соседей по графу HNSW
+void testHnswIndex() {
+    testStart("testHnswIndex");
+
+    const int dimension = 24, count = 3000, queryCount = 50, k = 10;
+    MyMatrix<float> vectors(count, dimension);
+    for(int i = 0; i < count; i++)
+        vectors.set_row(i, MyVectorGenerators::random_vector(dimension, 1000 + i, -1.0f, 1.0f).materialize());
+
+    MyVectorIndex::FlatIndex<float> exact(dimension);
+    exact.add(vectors);
+    MyVectorIndex::HnswIndex<float> parallel(dimension, MyVectorIndex::L2, 12, 100);
+    parallel.add(vectors, 4);
+    MyVectorIndex::HnswIndex<float> serial(dimension, MyVectorIndex::L2, 12, 100);
+    for(int i = 0; i < count; i++)
+        serial.add(vectors.get_row(i));
+
+    // доля точных соседей среди найденных приближённо
+    MyMatrix<float> queries(queryCount, dimension);
+    for(int i = 0; i < queryCount; i++)
+        queries.set_row(i, MyVectorGenerators::random_vector(dimension, 5 + i, -1.0f, 1.0f).materialize());
+    MyVector<MyVectorIndex::Neighbor<float>> truth = exact.search(queries, k);
+    MyVector<MyVectorIndex::Neighbor<float>> approximate = parallel.search(queries, k, 100, 4);
+    int hits = 0, serialHits = 0;
+    for(int q = 0; q < queryCount; q++) {
+        MyVector<MyVectorIndex::Neighbor<float>> found = serial.search(queries.get_row(q), k, 100);
+        for(int i = 0; i < k; i++)
+            for(int j = 0; j < k; j++) {
+                hits += approximate[q * k + i].id == truth[q * k + j].id;
+                serialHits += found[i].id == truth[q * k + j].id;
+            }
+    }
+    if (hits < queryCount * k * 9 / 10 || serialHits < queryCount * k * 9 / 10)
+        fail("low recall");
+
+    parallel.save("testHnswIndex.bin");
+    MyVectorIndex::HnswIndex<float> loaded = MyVectorIndex::HnswIndex<float>::load("testHnswIndex.bin");
+    truncateFile("testHnswIndex.bin", 1000);
+    try {
+        MyVectorIndex::HnswIndex<float>::load("testHnswIndex.bin");
+        fail("no exception");
+    } catch(VectorException &e2) { }
+    std::remove("testHnswIndex.bin");
+    MyVector<MyVectorIndex::Neighbor<float>> reloaded = loaded.search(queries, k, 100);
+    if (loaded.get_size() != count)
+        fail("invalid loaded index");
+    for(int i = 0; i < queryCount * k; i++)
+        if (reloaded[i].id != approximate[i].id)
+            fail("invalid loaded search");
+
+    // k, близкое к количеству векторов, при разреженном графе: возвращаются только
+    // различные реальные узлы, в пакетном поиске недостающие соседи - {-1, +inf} в конце строки
+    const int sparseCount = 200;
+    MyVectorIndex::HnswIndex<float> sparse(dimension, MyVectorIndex::L2, 2, 4);
+    for(int i = 0; i < sparseCount; i++)
+        sparse.add(vectors.get_row(i));
+    MyVector<MyVectorIndex::Neighbor<float>> all = sparse.search(queries.get_row(0), sparseCount, 1);
+    MyVector<MyVectorIndex::Neighbor<float>> allRows = sparse.search(queries, sparseCount, 1, 4);
+    if (all.get_length() > sparseCount || all.get_length() == 0)
+        fail("invalid sparse search length");
+    for(int q = 0; q < queryCount; q++) {
+        MyVector<MyVectorIndex::Neighbor<float>> row = q == 0 ? all : sparse.search(queries.get_row(q), sparseCount, 1);
+        std::unordered_set<int> ids;
+        for(int i = 0; i < row.get_length(); i++) {
+            if (row[i].id < 0 || row[i].id >= sparseCount || !ids.insert(row[i].id).second)
+                fail("invalid sparse search id");
+            if (allRows[q * sparseCount + i].id != row[i].id)
+                fail("invalid sparse batch search");
+        }
+        for(int i = row.get_length(); i < sparseCount; i++)
+            if (allRows[q * sparseCount + i].id != -1 || !std::isinf(allRows[q * sparseCount + i].distance))
+                fail("invalid sparse batch padding");
+    }
+
+    // при косинусной мере длина запроса не влияет на результат
+    MyVectorIndex::HnswIndex<double> cosine(3, MyVectorIndex::COSINE);
+    cosine.add(MyVector<double>{1, 0, 0});
+    cosine.add(MyVector<double>{0, 1, 0});
+    cosine.add(MyVector<double>{1, 1, 0});
+    MyVector<MyVectorIndex::Neighbor<double>> nearest = cosine.search(MyVector<double>{5, 5, 0}, 2);
+    if (nearest[0].id != 2 || std::fabs(nearest[0].distance) > 1e-12 || nearest.get_length() != 2)
+        fail("invalid cosine search");
+
+    testOk();
+}
+
+// квантильный скетч KLL
+void testQuantileSketch() {
+    testStart("testQuantileSketch");
+
+    const int count = 200000;
+    MyVector<double> values = MyVectorGenerators::random_vector(count, 3, 0.0, 1.0).materialize();
+    MyVector<double> sorted(values);
+    MyVectorAlgorithms::sort(sorted);
+
+    MyVectorSketch::KllSketch<double> sketch;
+    sketch.update(values);
+    MyVectorSketch::KllSketch<double> parallel = MyVectorSketch::build(MyVectorSketch::KllSketch<double>(),
+                                                                       values, MyVectorAlgorithms::AlgorithmSettings(4, 1));
+
+    if (sketch.get_count() != count || parallel.get_count() != count)
+        fail("invalid count");
+    if (sketch.get_min() != sorted[0] || sketch.get_max() != sorted[count - 1] || parallel.get_max() != sorted[count - 1])
+        fail("invalid min or max");
+    if (sketch.get_retained() > 2000)
+        fail("sketch is too large");
+
+    // непустой prototype учитывается один раз и при многопоточном построении
+    MyVectorSketch::KllSketch<double> seeded;
+    seeded.update(MyVector<double>{-1, -2, -3, -4, -5});
+    MyVectorSketch::KllSketch<double> seededSerial =
+        MyVectorSketch::build(seeded, values, MyVectorAlgorithms::AlgorithmSettings(1));
+    MyVectorSketch::KllSketch<double> seededParallel =
+        MyVectorSketch::build(seeded, values, MyVectorAlgorithms::AlgorithmSettings(4, 1));
+    if (seededSerial.get_count() != count + 5 || seededParallel.get_count() != seededSerial.get_count() ||
+        seededParallel.get_min() != -5)
+        fail("prototype counted more than once");
+
+    // слияние скетча с самим собой удваивает количество
+    MyVectorSketch::KllSketch<double> doubled(seededSerial);
+    doubled.merge(doubled);
+    if (doubled.get_count() != 2 * seededSerial.get_count() || doubled.get_min() != -5 ||
+        std::fabs(doubled.quantile(0.5) - seededSerial.quantile(0.5)) > 0.02)
+        fail("invalid self merge");
+
+    for(int i = 1; i < 10; i++) {
+        double q = i / 10.0;
+        double exact = sorted[(int)(q * count)];
+        if (std::fabs(sketch.quantile(q) - exact) > 0.02 || std::fabs(parallel.quantile(q) - exact) > 0.02)
+            fail("invalid quantile");
+        if (std::fabs(sketch.rank(exact) - q) > 0.02)
+            fail("invalid rank");
+    }
+
+    sketch.update(std::nan(""));
+    if (sketch.get_count() != count)
+        fail("NaN must be skipped");
+
+    MyVectorSketch::KllSketch<int> empty;
+    try {
+        empty.quantile(0.5);
+        fail("no exception");
+    } catch(VectorException &e2) { }
+
+    try {
+        empty.merge(MyVectorSketch::KllSketch<int>(100));
+        fail("no exception");
+    } catch(VectorException &e2) { }
+
+    testOk();
+}
+
+// гистограммы с равными и логарифмическими корзинами
+void testHistogram() {
+    testStart("testHistogram");
+
+    MyVector<int> values = MyVectorGenerators::iota(120, -5).materialize();
+    MyVectorSketch::Histogram<int> histogram(0, 100, 10);
+    histogram.update(values);
+    if (histogram.get_underflow() != 5 || histogram.get_overflow() != 15 || histogram.get_count() != 120)
+        fail("invalid histogram bounds");
+    for(int i = 0; i < 10; i++)
+        if (histogram.get_bucket(i) != 10 || histogram.bucket_lower(i) != i * 10)
+            fail("invalid histogram bucket");
+    if (std::fabs(histogram.quantile(0.5) - 55) > 1e-9)
+        fail("invalid histogram quantile");
+
+    MyVectorSketch::Histogram<int> parallel = MyVectorSketch::build(MyVectorSketch::Histogram<int>(0, 100, 10),
+                                                                    values, MyVectorAlgorithms::AlgorithmSettings(3, 1));
+    for(int i = 0; i < 10; i++)
+        if (parallel.get_bucket(i) != histogram.get_bucket(i))
+            fail("invalid parallel histogram");
+
+    MyVectorSketch::Histogram<int> seeded(0, 100, 10);
+    seeded.update(MyVector<int>{5, 5, 150});
+    MyVectorSketch::Histogram<int> seededSerial =
+        MyVectorSketch::build(seeded, values, MyVectorAlgorithms::AlgorithmSettings(1));
+    MyVectorSketch::Histogram<int> seededParallel =
+        MyVectorSketch::build(seeded, values, MyVectorAlgorithms::AlgorithmSettings(3, 1));
+    if (seededParallel.get_count() != seededSerial.get_count() || seededParallel.get_count() != values.get_length() + 3 ||
+        seededParallel.get_bucket(0) != histogram.get_bucket(0) + 2 || seededParallel.get_overflow() != histogram.get_overflow() + 1)
+        fail("prototype counted more than once");
+
+    // граничные значения пачкой (и в SIMD-блоках, и в хвосте) и по одному
+    const double infinity = std::numeric_limits<double>::infinity();
+    MyVector<double> edges{0, -infinity, 100, infinity, std::nan(""), std::nextafter(100.0, 0.0),
+                           -1e300, 1e300, std::nextafter(0.0, -1.0), 9.999999, 10, 99.5, 55};
+    MyVectorSketch::Histogram<double> batch(0, 100, 10);
+    MyVectorSketch::Histogram<double> single(0, 100, 10);
+    batch.update(edges);
+    for(int i = 0; i < edges.get_length(); i++)
+        single.update(edges[i]);
+    if (batch.get_underflow() != 3 || batch.get_overflow() != 4 || batch.get_bucket(0) != 2 ||
+        batch.get_bucket(1) != 1 || batch.get_bucket(5) != 1 || batch.get_bucket(9) != 2)
+        fail("invalid histogram edge values");
+    for(int i = 0; i < 10; i++)
+        if (batch.get_bucket(i) != single.get_bucket(i))
+            fail("batch and single updates differ");
+
+    MyVectorSketch::LogHistogram<double> logEdges(1, 1000, 0.01);
+    logEdges.update(MyVector<double>{1, 1000, std::nextafter(1.0, 0.0), 0, -5, infinity, std::nan(""),
+                                     std::nextafter(1000.0, 2000.0), 999.9, 10});
+    if (logEdges.get_underflow() != 3 || logEdges.get_overflow() != 3 || logEdges.get_bucket(0) != 1 ||
+        logEdges.get_bucket(logEdges.get_bucket_count() - 1) != 2 || logEdges.get_count() != 10)
+        fail("invalid log histogram edge values");
+
+    // логарифмически равномерные значения от 1e-3 до 1e3
+    const int count = 100000;
+    MyVector<double> exponents = MyVectorGenerators::random_vector(count, 11, -3.0, 3.0).materialize();
+    MyVector<double> latencies(count);
+    for(int i = 0; i < count; i++)
+        latencies[i] = std::pow(10.0, exponents[i]);
+    MyVector<double> sorted(latencies);
+    MyVectorAlgorithms::sort(sorted);
+
+    MyVectorSketch::LogHistogram<double> logHistogram(1e-3, 1e3, 0.01);
+    logHistogram.update(latencies);
+    logHistogram.update(std::nan(""));
+    logHistogram.update(0.0);
+    if (logHistogram.get_overflow() != 1 || logHistogram.get_underflow() != 1 || logHistogram.get_bucket_count() != 691)
+        fail("invalid log histogram bounds");
+
+    MyVectorSketch::LogHistogram<double> merged(1e-3, 1e3, 0.01);
+    merged.update(latencies);
+    merged.merge(MyVectorSketch::build(MyVectorSketch::LogHistogram<double>(1e-3, 1e3, 0.01), latencies,
+                                       MyVectorAlgorithms::AlgorithmSettings(4, 1)));
+    for(int i = 1; i < 100; i++) {
+        double q = i / 100.0;
+        double exact = sorted[(int)std::ceil(q * count) - 1];
+        if (std::fabs(merged.quantile(q) - exact) > 0.0101 * exact)
+            fail("invalid log histogram quantile");
+    }
+
+    try {
+        histogram.merge(MyVectorSketch::Histogram<int>(0, 100, 20));
+        fail("no exception");
+    } catch(VectorException &e2) { }
+
+    testOk();
+}
+
+// сравнение векторов на равенство и лексикографическое сравнение
+void testVectorComparison() {
+    testStart("testVectorComparison");
+
+    MyVector<int> a = MyVectorGenerators::iota(1000, 0).materialize();
+    MyVector<int> b(a);
+    if (!(a == b) || a != b || a < b || a > b || !(a <= b) || !(a >= b))
+        fail("equal vectors");
+
+    // различие в каждой позиции, в том числе в хвосте после полных SIMD-блоков
+    for(int position = 0; position < 1000; position += 37) {
+        b[position] = a[position] + 1;
+        if (a == b || !(a != b) || !(a < b) || !(b > a) || b <= a)
+            fail("different vectors");
+        b[position] = a[position];
+    }
+
+    MyVector<int> prefix = MyVectorGenerators::iota(999, 0).materialize();
+    if (prefix == a || !(prefix < a) || !(MyVector<int>(0) < prefix))
+        fail("prefix must be less");
+
+    MyVector<double> zeros{0.0, 1.0}, negativeZeros{-0.0, 1.0}, nan{std::nan(""), 1.0};
+    if (zeros != negativeZeros || nan == nan)
+        fail("invalid IEEE 754 comparison");
+
+    MyVector<long> longs{1, 2, 3, 4, 5}, bigger{1, 2, 3, 4, 6};
+    MyVector<float> floats{1, 2, 3, 4, 5, 6, 7, 8, 9}, smaller{1, 2, 3, 4, 5, 6, 7, 8, 8};
+    if (!(longs < bigger) || !(smaller < floats) || floats == smaller)
+        fail("invalid comparison");
+
+    testOk();
+}
+
+// хеш содержимого вектора
+void testVectorHash() {
+    testStart("testVectorHash");
+
+    // эталонные значения XXH64
+    MyVectorHasher empty;
+    MyVectorHasher abc;
+    abc.update("abc", 3);
+    if (empty.digest() != 0xef46db3751d8e999ULL || abc.digest() != 0x44bc2cf5ad770999ULL)
+        fail("invalid XXH64 value");
+
+    // длинные входы проходят через 32-байтовые полосы и хвосты по 8, 4 и 1 байту
+    const char *sentence = "Nobody inspects the spammish repetition";
+    MyVectorHasher text;
+    text.update(sentence, std::strlen(sentence));
+    unsigned char bytes[100];
+    for(int i = 0; i < 100; i++)
+        bytes[i] = (unsigned char)i;
+    MyVectorHasher hundred, hundredParts;
+    hundred.update(bytes, sizeof(bytes));
+    hundredParts.update(bytes, 33);
+    hundredParts.update(bytes + 33, sizeof(bytes) - 33);
+    if (text.digest() != 0xfbcea83c8a378bf1ULL || hundred.digest() != 0x6ac1e58032166597ULL ||
+        hundredParts.digest() != 0x6ac1e58032166597ULL)
+        fail("invalid XXH64 value");
+
+    // хеш не зависит от того, какими частями подаются данные
+    MyVector<long> values = MyVectorGenerators::random_vector(333, 5, -1000L, 1000L).materialize();
+    MyVectorHasher whole(7), parts(7);
+    whole.update(values.data(), values.get_length() * sizeof(long));
+    for(int i = 0; i < values.get_length(); i += 10)
+        parts.update(values.data() + i, std::min(10, values.get_length() - i) * sizeof(long));
+    if (whole.digest() != parts.digest() || whole.digest() != values.hash(7) || values.hash(7) == values.hash(8))
+        fail("invalid incremental hash");
+
+    MyVector<double> zeros{0.0, 1.0}, negativeZeros{-0.0, 1.0};
+    if (zeros.hash() != negativeZeros.hash())
+        fail("equal vectors must have equal hashes");
+
+    std::unordered_set<MyVector<int>> unique;
+    for(int i = 0; i < 100; i++)
+        unique.insert(MyVectorGenerators::iota(10, i % 25).materialize());
+    if (unique.size() != 25 || unique.count(MyVectorGenerators::iota(10, 3).materialize()) != 1)
+        fail("invalid hash set");
+
+    testOk();
+}
+
 int main(int argc, char *argv[])
 {
     try {
@@ -490,6 +1865,88 @@ int main(int argc, char *argv[])
 
         // метод получения итератора на начало вектора (первый элемент)
         testIterator();
+
+        // сжатый вектор: frame-of-reference, дельта-кодирование и упаковка битов
+        testCompressedVector();
+
+        // сортировка: поразрядная для чисел, слиянием для остальных типов
+        testSortAlgorithm();
+
+        // включающая и исключающая префиксные суммы
+        testScanAlgorithm();
+
+        // стабильное разбиение по предикату
+        testStablePartitionAlgorithm();
+
+        // удаление подряд идущих повторов
+        testUniqueAlgorithm();
+
+        // двоичный поиск в отсортированном векторе
+        testLowerBoundAlgorithm();
+
+        // одновременное добавление элементов из нескольких потоков
+        testConcurrentVector();
+
+        // матрица: доступ к элементам, строки, столбцы и транспонирование
+        testMatrix();
+
+        // произведение матрицы на вектор и матриц
+        testMatrixMultiply();
+
+        // this = a * x + this
+        testAxpyOperation();
+
+        // this = a * x + b * this
+        testAxpbyOperation();
+
+        // поэлементное умножение и деление
+        testHadamardOperation();
+
+        // this = a * b + c поэлементно
+        testFmaOperation();
+
+        // ограничение элементов отрезком
+        testClampOperation();
+
+        // модуль каждого элемента
+        testAbsOperation();
+
+        // сбор элементов по списку индексов
+        testGather();
+
+        // запись элементов по списку индексов
+        testScatter();
+
+        // агрегаты с кэшированием по блокам и отслеживанием изменений
+        testAggregateCache();
+
+        // публикация версий и согласованные снимки для читателей
+        testRcuVector();
+        testRcuSnapshotOutlivesReader();
+
+        // снимки из нескольких потоков во время записи
+        testRcuVectorConcurrentReaders();
+
+        // ленивые векторы: константа, прогрессия, сетка и псевдослучайный вектор
+        testGenerators();
+
+        // вычитание ленивых векторов из MyVector
+        testGeneratorArithmetic();
+
+        // потоковая обработка данных порциями
+        testPipeline();
+
+        // точный и приближённый поиск ближайших соседей
+        testFlatIndex();
+        testHnswIndex();
+
+        // однопроходные квантили и гистограммы
+        testQuantileSketch();
+        testHistogram();
+
+        // сравнение и хеширование векторов
+        testVectorComparison();
+        testVectorHash();
     } catch(std::exception &e) {
         testFailed(e.what());
     }